@@ -18,6 +18,14 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# Optional in-process backend for status, refs, diffs and ahead/behind.
+packagesExist(libgit2) {
+    QT += concurrent
+    CONFIG += link_pkgconfig
+    PKGCONFIG += libgit2
+    DEFINES += HAVE_LIBGIT2
+}
+
 SOURCES += \
     main.cpp
 HEADERS += \
@@ -6,9 +6,38 @@ Features:
  - Clone repositories (git clone)
  - Check for remote updates (git fetch + git status parsing)
  - Pull latest (git pull)
- - Detect changed files (git status --porcelain)
+ - Detect changed files (git status --porcelain=v2 -z, parsed in place into typed entries with
+   branch ahead/behind)
+ - Live status: the selected and pinned repositories are watched (QFileSystemWatcher) and only
+   the directories that changed are re-queried
+ - Status cache keyed on index, HEAD and a working-tree fingerprint, kept across restarts
  - Show file diffs (git diff)
  - Commit & push local changes (git add -A, git commit -m, git push)
+ - All git commands run as non-blocking jobs on a bounded pool (JobPool), serialized per
+   repository and parallel across repositories
+ - Ref/object lookups go through long-lived `git cat-file --batch-check` helpers (GitHelperPool)
+ - Read-only queries go through a GitBackend: the git CLI, or libgit2 in-process when built with it
+ - Output of long-running commands streams line by line into the log and the Jobs pane
+ - Check Updates and Commit & Push run as step pipelines over every selected repository
+ - Large command output spills to a memory-mapped temp file; diffs are shown page by page
+ - Clone profiles (full, shallow, blobless, treeless, single-branch), remembered per repository
+ - "auto" clone profile chosen from GitHub metadata (size, fork, archived), confirmed before cloning
+ - Mirror mode: one bare repository per repo under .git-manager/mirrors, checkouts are its worktrees
+ - Sparse checkout editor (cone mode); clones and checkouts use parallel checkout workers
+ - Large-repo mode per repository: untracked cache, fsmonitor daemon, index v4 and sparse index,
+   with status timed before and after
+ - Add Worktree checks out another branch of a local repository next to it
+ - Clones seed from <bundle dir>/<name>.bundle when present and fetch only the delta
+ - Optional shared object cache (bare repo in the clone directory) that clones reference
+ - Disk budget for the clone directory: least recently used clean clones are evicted down to a
+   bundle or their .git directory and restored when selected again
+ - Read-only snapshots: GitHub tarballs streamed straight into tar, no history and no temp archive
+ - Network failures retry with jittered backoff; interrupted clones resume (init + incremental fetch)
+ - Selected repositories clone in parallel (limited) with per-repo and overall progress and ETA
+ - Dashboard: status, branch, ahead/behind and last fetch of every local clone, computed in
+   parallel on the job pool and filled into a sortable table as results arrive
+ - Wall time, CPU, peak RSS and I/O of every git command, per repository and operation,
+   in the Resources tab (exportable as CSV)
 
 NOTE:
  - To avoid rate-limits, you should provide a GitHub personal access token.
@@ -44,23 +73,2388 @@ Build (example using qmake):
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QTimer>
+#include <QThread>
+#include <QSet>
+#include <QMap>
+#include <QFile>
+#include <QFileInfo>
+#include <QComboBox>
+#include <QTabWidget>
+#include <QSpinBox>
+#include <QTemporaryFile>
+#include <QSharedPointer>
+#include <QElapsedTimer>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QTextStream>
+#include <QSaveFile>
+#include <QProgressBar>
+#include <QSettings>
+#include <QMenu>
+#include <QCheckBox>
+#include <QRandomGenerator>
+#include <QTreeWidget>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFileSystemWatcher>
+#include <QPointer>
+#include <QCryptographicHash>
+#include <functional>
+#include <cstring>
+#include <memory>
+#ifdef HAVE_LIBGIT2
+#include <QRunnable>
+#include <QThreadPool>
+#include <git2.h>
+#endif
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#endif
 
-static bool runCommand(const QString &program, const QStringList &args, QString &stdoutOut, QString &stderrOut, int timeoutMs = 120000)
+//=========================== JOB ENGINE =================================
+// Captured command output. Up to memoryLimit bytes stay in memory; beyond that the
+// whole capture moves to a temporary file that is memory-mapped once writing is
+// done, so consumers page through it without ever holding it on the heap.
+class OutputBuffer {
+public:
+    static const qint64 defaultMemoryLimit = 1024*1024;
+
+    explicit OutputBuffer(qint64 memoryLimit=defaultMemoryLimit) : limit(memoryLimit) {}
+    ~OutputBuffer()
+    {
+        if(file && mapped) file->unmap(mapped);
+        delete file;
+    }
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    void append(const char *data, qint64 len)
+    {
+        total += len;
+        if(!file && mem.size()+len<=limit){ mem.append(data, int(len)); return; }
+        if(!file){
+            file = new QTemporaryFile(QDir(QDir::tempPath()).filePath("git-manager-XXXXXX.out"));
+            if(!file->open()){ delete file; file = nullptr; total -= len; return; }   // keep what fits
+            file->write(mem);
+            mem.clear();
+            mem.squeeze();
+        }
+        file->write(data, len);
+    }
+    void append(const QByteArray &data){ append(data.constData(), data.size()); }
+
+    // Writing is over; maps the spill file for reading. Nothing may be appended after this.
+    void close()
+    {
+        if(!file || mapped || total==0) return;
+        file->flush();
+        mapped = file->map(0, total);
+    }
+
+    qint64 size() const { return total; }
+    bool spilled() const { return file!=nullptr; }
+
+    // Copy of [offset, offset+len), clamped to the captured size.
+    QByteArray page(qint64 offset, qint64 len) const
+    {
+        offset = qBound<qint64>(0, offset, total);
+        len = qMin(len, total-offset);
+        if(!file) return mem.mid(int(offset), int(len));
+        if(mapped) return QByteArray(reinterpret_cast<const char*>(mapped)+offset, int(len));
+        file->seek(offset);
+        return file->read(len);
+    }
+
+    // Whole capture. Zero-copy view over the mapping when spilled; valid while this buffer lives.
+    QByteArray bytes() const
+    {
+        if(!file) return mem;
+        if(mapped) return QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), int(total));
+        return page(0, total);
+    }
+
+private:
+    qint64 limit;
+    qint64 total = 0;
+    QByteArray mem;
+    QTemporaryFile *file = nullptr;
+    uchar *mapped = nullptr;
+};
+
+// What one command cost. CPU, peak RSS and I/O include the processes git itself
+// waited for (ssh, index-pack, ...); -1 means not measured.
+struct ResourceUsage {
+    qint64 wallMs = -1;                         // -1 if the process never started
+    qint64 userMs = -1, sysMs = -1;
+    qint64 maxRssKb = -1;
+    qint64 readBytes = -1, writeBytes = -1;     // all reads/writes incl. pipes and sockets (Linux)
+    qint64 diskReadBytes = -1, diskWriteBytes = -1;     // what actually hit storage
+};
+
+struct JobResult {
+    bool ok = false;
+    bool timedOut = false;
+    bool cancelled = false;
+    int exitCode = -1;
+    QString out;            // stdout; at most the first OutputBuffer::defaultMemoryLimit bytes
+    QString err;
+    QSharedPointer<OutputBuffer> output;    // complete stdout of non-streamed jobs that ran; may be null
+    ResourceUsage usage;
+};
+
+// Splits a byte stream into lines. Git redraws progress with '\r'; those partial
+// lines are reported separately so only the latest one needs to be shown.
+class LineFramer {
+public:
+    void feed(const QByteArray &data, QStringList &lines, QString &progress)
+    {
+        for(char c : data){
+            if(c=='\n'){
+                lines << QString::fromUtf8(partial);
+                partial.clear();
+            } else if(c=='\r'){
+                if(!partial.isEmpty()) progress = QString::fromUtf8(partial);
+                partial.clear();
+            } else partial += c;
+        }
+    }
+
+    QString takeRest()
+    {
+        QString rest = QString::fromUtf8(partial);
+        partial.clear();
+        return rest;
+    }
+
+private:
+    QByteArray partial;
+};
+
+// Scheduling class. Interactive work (what the user just clicked) jumps ahead of
+// queued normal and background work and has slots reserved for it.
+enum class JobPriority { Interactive = 0, Normal = 1, Background = 2 };
+
+// QProcess whose child leads its own process group, so a signal to the group also
+// reaches everything git spawns (ssh, remote helpers, index-pack).
+//
+// On Unix the child forks once more and stays behind as a tiny reaper: it waits for
+// the command with wait4(), sends its rusage (and /proc/<pid>/io) back through a
+// pipe and exits the way the command did. QProcess reaps its own child itself, so
+// this is the only place the command's rusage can be picked up.
+class GroupProcess : public QProcess {
+public:
+    using QProcess::QProcess;
+    ~GroupProcess() override { closeReport(); }
+
+    void startAccounted(const QString &program, const QStringList &args)
+    {
+#ifdef Q_OS_UNIX
+        if(::pipe(reportFds)==0){
+            for(int fd : reportFds) ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+            ::fcntl(reportFds[0], F_SETFL, O_NONBLOCK);
+        } else reportFds[0] = reportFds[1] = -1;
+#endif
+        start(program, args);
+#ifdef Q_OS_UNIX
+        if(reportFds[1]>=0){ ::close(reportFds[1]); reportFds[1] = -1; }
+#endif
+    }
+
+    // Reads the reaper's report; call once after finished(). Wall time is the caller's.
+    ResourceUsage takeUsage()
+    {
+        ResourceUsage u;
+#ifdef Q_OS_UNIX
+        if(reportFds[0]<0) return u;
+        Report rep;
+        ssize_t n;
+        do n = ::read(reportFds[0], &rep, sizeof rep); while(n<0 && errno==EINTR);
+        closeReport();
+        if(n!=ssize_t(sizeof rep)) return u;
+        u.userMs = qint64(rep.ru.ru_utime.tv_sec)*1000 + rep.ru.ru_utime.tv_usec/1000;
+        u.sysMs = qint64(rep.ru.ru_stime.tv_sec)*1000 + rep.ru.ru_stime.tv_usec/1000;
+#ifdef Q_OS_MACOS
+        u.maxRssKb = qint64(rep.ru.ru_maxrss)/1024;     // bytes on macOS
+#else
+        u.maxRssKb = qint64(rep.ru.ru_maxrss);
+#endif
+        u.diskReadBytes = qint64(rep.ru.ru_inblock)*512;
+        u.diskWriteBytes = qint64(rep.ru.ru_oublock)*512;
+        for(const QByteArray &line : QByteArray(rep.io, rep.ioLen).split('\n')){
+            if(line.startsWith("rchar:")) u.readBytes = line.mid(6).trimmed().toLongLong();
+            else if(line.startsWith("wchar:")) u.writeBytes = line.mid(6).trimmed().toLongLong();
+        }
+#endif
+        return u;
+    }
+
+protected:
+#ifdef Q_OS_UNIX
+    void setupChildProcess() override
+    {
+        ::setpgid(0, 0);
+        if(reportFds[1]<0) return;
+        pid_t pid = ::fork();
+        if(pid<=0) return;      // the command itself (or no reaper): exec as usual
+        reap(pid, reportFds[1]);
+    }
+#endif
+
+private:
+#ifdef Q_OS_UNIX
+    struct Report {
+        struct rusage ru;
+        int ioLen;
+        char io[512];
+    };
+    int reportFds[2] = {-1, -1};
+
+    // Runs in a fork of a threaded process: async-signal-safe calls only.
+    [[noreturn]] static void reap(pid_t pid, int reportFd)
+    {
+        ::dup2(reportFd, 0);
+        closeFrom(1);
+        // Group signals are meant for the command; outlive it to report and mirror its end.
+        ::signal(SIGTERM, SIG_IGN); ::signal(SIGINT, SIG_IGN);
+        ::signal(SIGHUP, SIG_IGN); ::signal(SIGPIPE, SIG_IGN);
+        Report rep;
+        ::memset(&rep, 0, sizeof rep);
+#ifdef Q_OS_LINUX
+        // /proc/<pid>/io stays readable while the command is a zombie.
+        siginfo_t info;
+        while(::waitid(P_PID, id_t(pid), &info, WEXITED|WNOWAIT)<0 && errno==EINTR) {}
+        char path[32];
+        int fd = ::open(procIoPath(path, pid), O_RDONLY);
+        if(fd>=0){
+            ssize_t n = ::read(fd, rep.io, sizeof rep.io);
+            rep.ioLen = n>0 ? int(n) : 0;
+            ::close(fd);
+        }
+#endif
+        int status = 0;
+        pid_t got;
+        do got = ::wait4(pid, &status, 0, &rep.ru); while(got<0 && errno==EINTR);
+        if(got<0) ::_exit(127);
+        ssize_t ignored = ::write(0, &rep, sizeof rep);
+        (void)ignored;
+        if(WIFSIGNALED(status)){
+            ::signal(WTERMSIG(status), SIG_DFL);
+            ::kill(::getpid(), WTERMSIG(status));
+        }
+        ::_exit(WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+    }
+
+    static void closeFrom(int first)
+    {
+#if defined(Q_OS_LINUX) && defined(SYS_close_range)
+        if(::syscall(SYS_close_range, first, ~0U, 0)==0) return;
+#endif
+        struct rlimit rl;
+        int maxFd = 1024;
+        if(::getrlimit(RLIMIT_NOFILE, &rl)==0 && rl.rlim_cur!=RLIM_INFINITY) maxFd = int(qMin<rlim_t>(rl.rlim_cur, 65536));
+        for(int fd=first; fd<maxFd; ++fd) ::close(fd);
+    }
+
+    static const char *procIoPath(char *buf, pid_t pid)
+    {
+        char digits[16];
+        int n = 0, i = 0;
+        do { digits[n++] = char('0' + pid%10); pid /= 10; } while(pid>0);
+        for(const char *p = "/proc/"; *p; ++p) buf[i++] = *p;
+        while(n>0) buf[i++] = digits[--n];
+        for(const char *p = "/io"; *p; ++p) buf[i++] = *p;
+        buf[i] = 0;
+        return buf;
+    }
+#endif
+
+    void closeReport()
+    {
+#ifdef Q_OS_UNIX
+        for(int &fd : reportFds) if(fd>=0){ ::close(fd); fd = -1; }
+#endif
+    }
+};
+
+// One non-blocking git (or other) process. Created and started by JobPool.
+class GitJob : public QObject {
+    Q_OBJECT
+public:
+    typedef std::function<void(const JobResult &)> Callback;
+
+    GitJob(const QString &program, const QStringList &args, int timeoutMs, QObject *parent=nullptr)
+        : QObject(parent), program(program), args(args), timeoutMs(timeoutMs), id(++lastId) {}
+
+    QString program;
+    QStringList args;
+    int timeoutMs;          // 0 = no timeout
+    Callback onDone;
+    const quint64 id;
+    QString repo;           // serialization key, set by JobPool
+    JobPriority priority = JobPriority::Normal;
+    qint64 queuedAt = 0;    // ms since epoch, for aging
+    bool readOnly = false;  // may share its repository with other read-only jobs
+    QString group;          // jobs of one group share the slots set by JobPool::setGroupLimit
+    QString cleanupDir;     // removed if the job is cancelled after starting, unless it existed before start
+    // Streamed jobs emit lines() while running and keep only the last tailLines of
+    // each channel in the result; the rest never accumulates in memory.
+    bool stream = false;
+
+    static const int tailLines = 200;
+    static const int flushIntervalMs = 100;
+    static const int maxLinesPerFlush = 200;
+    static const int maxPendingLines = 2000;
+    static const int killGraceMs = 3000;
+
+    bool isRunning() const { return proc && proc->state()!=QProcess::NotRunning; }
+    const JobResult &result() const { return res; }
+    QString commandLine() const { return program + " " + args.join(" "); }
+
+    // The git subcommand ("fetch", "status", ...) for accounting; other programs by name.
+    QString operation() const
+    {
+        if(QFileInfo(program).baseName()!="git") return QFileInfo(program).baseName();
+        for(int i=0; i<args.size(); ++i){
+            const QString &a = args[i];
+            if(a=="-C" || a=="-c" || a=="--git-dir" || a=="--work-tree"){ ++i; continue; }
+            if(!a.startsWith('-')) return a;
+        }
+        return QString();
+    }
+
+    void start()
+    {
+        if(!cleanupDir.isEmpty() && QFileInfo::exists(cleanupDir)) cleanupDir.clear();
+        proc = new GroupProcess(this);
+        wall.start();
+        if(!stream) outCapture.reset(new OutputBuffer());
+        flushTimer = new QTimer(this);
+        flushTimer->setInterval(flushIntervalMs);
+        connect(flushTimer, &QTimer::timeout, this, &GitJob::flushLines);
+        connect(proc, &QProcess::started, this, &GitJob::started);
+        connect(proc, &QProcess::readyReadStandardOutput, this, [this](){ onRead(false); });
+        connect(proc, &QProcess::readyReadStandardError, this, [this](){ onRead(true); });
+        connect(proc, &QProcess::errorOccurred, this, [this](QProcess::ProcessError e){
+            if(e!=QProcess::FailedToStart) return;
+            res.err = "Failed to start";
+            res.usage.wallMs = wall.elapsed();
+            finish();
+        });
+        connect(proc, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished), this,
+                [this](int code, QProcess::ExitStatus st){
+            onRead(false);
+            onRead(true);
+            if(stream){
+                for(LineFramer *f : {&outFramer, &errFramer}){
+                    QString rest = f->takeRest();
+                    if(rest.isEmpty()) continue;
+                    keepTail(f==&outFramer ? outTail : errTail, rest);
+                    queueLines({rest});
+                }
+                while(!pendingLines.isEmpty()) flushLines();
+            }
+            res.exitCode = code;
+            res.usage = proc->takeUsage();
+            res.usage.wallMs = wall.elapsed();
+            if(stream) res.out = outTail.join('\n');
+            else {
+                outCapture->close();
+                res.output = outCapture;
+                res.out = QString::fromUtf8(outCapture->page(0, OutputBuffer::defaultMemoryLimit));
+            }
+            res.err = res.timedOut ? "Timeout" : res.cancelled ? "Cancelled"
+                    : stream ? errTail.join('\n') : QString::fromUtf8(errBuf);
+            res.ok = !res.timedOut && !res.cancelled && st==QProcess::NormalExit && code==0;
+            outCapture.reset(); errBuf.clear();
+            finish();
+        });
+        if(timeoutMs>0){
+            QTimer::singleShot(timeoutMs, this, [this](){
+                if(!isRunning()) return;
+                res.timedOut = true;
+                signalGroup(true);
+            });
+        }
+        proc->startAccounted(program, args);
+    }
+
+    // Terminates the whole process group (SIGTERM, then SIGKILL after a grace period)
+    // and reports the job as cancelled rather than failed. Jobs not started yet finish
+    // immediately.
+    void cancel()
+    {
+        if(done || res.cancelled) return;
+        res.cancelled = true;
+        if(!isRunning()){ finish(); return; }
+        signalGroup(false);
+        QTimer::singleShot(killGraceMs, this, [this](){ if(isRunning()) signalGroup(true); });
+    }
+
+    // Hard stop without reporting; used on shutdown.
+    void abort()
+    {
+        onDone = nullptr;
+        if(!proc) return;
+        proc->disconnect(this);
+        if(isRunning()){ signalGroup(true); proc->waitForFinished(1000); }
+    }
+
+signals:
+    void started();
+    void lines(const QStringList &lines);
+    void progress(const QString &line);
+    void finished(const JobResult &r);
+
+private:
+    static quint64 lastId;
+    GroupProcess *proc = nullptr;
+    QElapsedTimer wall;
+    QTimer *flushTimer = nullptr;
+    QSharedPointer<OutputBuffer> outCapture;
+    QByteArray errBuf;      // capped at OutputBuffer::defaultMemoryLimit
+    LineFramer outFramer, errFramer;
+    QStringList outTail, errTail;
+    QStringList pendingLines;
+    QString pendingProgress;
+    int skippedLines = 0;
+    JobResult res;
+    bool done = false;
+
+    void onRead(bool err)
+    {
+        QByteArray chunk = err ? proc->readAllStandardError() : proc->readAllStandardOutput();
+        if(chunk.isEmpty()) return;
+        if(!stream){
+            if(!err) outCapture->append(chunk);
+            else if(errBuf.size()<OutputBuffer::defaultMemoryLimit) errBuf += chunk.left(int(OutputBuffer::defaultMemoryLimit - errBuf.size()));
+            return;
+        }
+        QStringList got;
+        (err ? errFramer : outFramer).feed(chunk, got, pendingProgress);
+        for(const QString &l : got) keepTail(err ? errTail : outTail, l);
+        queueLines(got);
+        if(!flushTimer->isActive()) flushTimer->start();
+    }
+
+    static void keepTail(QStringList &tail, const QString &line)
+    {
+        tail << line;
+        if(tail.size()>tailLines) tail.removeFirst();
+    }
+
+    // Backpressure towards the UI: when a process outpaces the flush rate the oldest
+    // undelivered lines are dropped and reported as a single "skipped" marker.
+    void queueLines(const QStringList &got)
+    {
+        pendingLines += got;
+        if(pendingLines.size()>maxPendingLines){
+            int drop = pendingLines.size() - maxPendingLines;
+            pendingLines = pendingLines.mid(drop);
+            skippedLines += drop;
+        }
+    }
+
+    void flushLines()
+    {
+        if(!pendingProgress.isEmpty()){ emit progress(pendingProgress); pendingProgress.clear(); }
+        if(pendingLines.isEmpty()){ flushTimer->stop(); return; }
+        QStringList batch = pendingLines.mid(0, maxLinesPerFlush);
+        pendingLines = pendingLines.mid(batch.size());
+        if(skippedLines){
+            batch.prepend(QString("[... %1 lines skipped ...]").arg(skippedLines));
+            skippedLines = 0;
+        }
+        emit lines(batch);
+    }
+
+    void signalGroup(bool hard)
+    {
+#ifdef Q_OS_UNIX
+        pid_t pid = pid_t(proc->processId());
+        if(pid>0 && ::kill(-pid, hard ? SIGKILL : SIGTERM)==0) return;
+#endif
+        if(hard) proc->kill(); else proc->terminate();
+    }
+
+    void finish()
+    {
+        if(done) return;
+        done = true;
+        if(flushTimer) flushTimer->stop();
+        if(res.cancelled){
+            if(res.err.isEmpty()) res.err = "Cancelled";
+            // a job cancelled while queued never made the directory, and start() never checked it
+            if(proc && !cleanupDir.isEmpty()) QDir(cleanupDir).removeRecursively();
+        }
+        emit finished(res);
+        if(onDone) onDone(res);
+    }
+};
+
+quint64 GitJob::lastId = 0;
+
+// Scheduler: writers on the same repository run strictly one after another (no
+// index.lock contention), read-only jobs may overlap each other but never a
+// writer; different repositories run in parallel, up to
+// maxConcurrent processes. The next job is the one with the best priority after
+// aging; ties go FIFO within a repository and round robin across repositories.
+// reservedInteractive slots are kept free of normal/background work.
+class JobPool : public QObject {
+    Q_OBJECT
+public:
+    explicit JobPool(int maxConcurrent, QObject *parent=nullptr)
+        : QObject(parent), maxConcurrent(qMax(1, maxConcurrent)) {}
+
+    ~JobPool() override
+    {
+        for(const QList<GitJob*> &q : queues) for(GitJob *j : q) j->onDone = nullptr;
+        for(GitJob *j : active) j->abort();
+    }
+
+    // `repo` serializes the job against others on that path; by default it is taken
+    // from a "-C <path>" argument. Jobs without a repository are never serialized.
+    GitJob *submit(const QString &program, const QStringList &args, int timeoutMs, GitJob::Callback done,
+                   const QString &repo=QString())
+    {
+        auto *job = new GitJob(program, args, timeoutMs, this);
+        job->onDone = done;
+        job->repo = repo.isEmpty() ? repoFromArgs(args) : QDir::cleanPath(repo);
+        job->queuedAt = QDateTime::currentMSecsSinceEpoch();
+        QList<GitJob*> &q = queues[job->repo];
+        q.append(job);
+        if(q.size()==1) order.append(job->repo);
+        ++queued;
+        QTimer::singleShot(0, this, &JobPool::pump);
+        emit changed();
+        return job;
+    }
+
+    // Running jobs are killed; queued ones are dropped and report cancellation straight away.
+    void cancel(GitJob *job)
+    {
+        if(active.contains(job)){ job->cancel(); return; }
+        auto it = queues.find(job->repo);
+        if(it==queues.end() || !it.value().removeOne(job)) return;
+        if(it.value().isEmpty()){ queues.erase(it); order.removeOne(job->repo); }
+        --queued;
+        job->cancel();
+        job->deleteLater();
+        emit changed();
+    }
+
+    void cancelAll()
+    {
+        QList<GitJob*> all;
+        for(const QList<GitJob*> &q : queues) all += q;
+        for(GitJob *j : all) cancel(j);
+        for(GitJob *j : active.values()) j->cancel();
+    }
+
+    GitJob *findRunning(quint64 id) const
+    {
+        for(GitJob *j : active) if(j->id==id) return j;
+        return nullptr;
+    }
+
+    void setMaxConcurrent(int n){ maxConcurrent = qMax(1, n); pump(); }
+    // At most n jobs of `group` run at once (on top of the overall limit).
+    void setGroupLimit(const QString &group, int n){ groupLimits[group] = qMax(1, n); pump(); }
+    int concurrency() const { return maxConcurrent; }
+    int running() const { return active.size(); }
+    int pending() const { return queued; }
+
+signals:
+    void jobStarted(GitJob *job);
+    void jobFinished(GitJob *job, const JobResult &r);
+    void changed();
+
+private:
+    QMap<QString, QList<GitJob*>> queues;   // per repository, FIFO; "" = unserialized
+    QStringList order;                      // repositories with queued work, round robin
+    QSet<QString> writing;                  // repositories with a running writer
+    QMap<QString, int> reading;             // running read-only jobs per repository
+    QSet<GitJob*> active;
+    int maxConcurrent;
+    int queued = 0;
+    int activeInteractive = 0;
+    QMap<QString, int> groupLimits;
+    QMap<QString, int> groupActive;
+
+    static const int reservedInteractive = 1;
+    static const int agingMs = 15000;       // waiting this long promotes a job by one class
+
+    static QString repoFromArgs(const QStringList &args)
+    {
+        int i = args.indexOf("-C");
+        return i>=0 && i+1<args.size() ? QDir::cleanPath(args[i+1]) : QString();
+    }
+
+    static double rank(const GitJob *job, qint64 now)
+    {
+        return int(job->priority) - double(now - job->queuedAt) / agingMs;
+    }
+
+    GitJob *takeNext()
+    {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        const int reserved = maxConcurrent>1 ? reservedInteractive : 0;
+        const bool interactiveOnly = active.size() - activeInteractive >= maxConcurrent - reserved;
+        GitJob *best = nullptr;
+        int bestPos = -1;
+        double bestRank = 0;
+        for(int i=0; i<order.size(); ++i){
+            const QString &key = order[i];
+            if(!key.isEmpty() && writing.contains(key)) continue;
+            const bool readersOnly = reading.value(key)>0;
+            for(GitJob *j : queues[key]){
+                if(interactiveOnly && j->priority!=JobPriority::Interactive) continue;
+                if(readersOnly && !j->readOnly && !key.isEmpty()) continue;
+                if(!j->group.isEmpty() && groupActive.value(j->group) >= groupLimits.value(j->group, maxConcurrent)) continue;
+                double r = rank(j, now);
+                if(!best || r<bestRank){ best = j; bestRank = r; bestPos = i; }
+            }
+        }
+        if(!best) return nullptr;
+        const QString key = order.takeAt(bestPos);
+        QList<GitJob*> &q = queues[key];
+        q.removeOne(best);
+        if(q.isEmpty()) queues.remove(key);
+        else order.append(key);
+        if(!key.isEmpty()){
+            if(best->readOnly) ++reading[key];
+            else writing.insert(key);
+        }
+        if(!best->group.isEmpty()) ++groupActive[best->group];
+        --queued;
+        return best;
+    }
+
+    void pump()
+    {
+        while(active.size()<maxConcurrent){
+            GitJob *job = takeNext();
+            if(!job) break;
+            active.insert(job);
+            if(job->priority==JobPriority::Interactive) ++activeInteractive;
+            connect(job, &GitJob::finished, this, [this, job](const JobResult &r){
+                active.remove(job);
+                if(job->priority==JobPriority::Interactive) --activeInteractive;
+                if(!job->readOnly) writing.remove(job->repo);
+                else if(reading.contains(job->repo) && --reading[job->repo]<=0) reading.remove(job->repo);
+                if(!job->group.isEmpty() && --groupActive[job->group]<=0) groupActive.remove(job->group);
+                job->deleteLater();
+                emit jobFinished(job, r);
+                emit changed();
+                pump();
+            });
+            emit jobStarted(job);
+            job->start();
+        }
+        emit changed();
+    }
+};
+
+//=========================== RETRY ======================================
+// Why a git command failed, read from its stderr. Only network trouble and
+// timeouts are worth trying again.
+enum class FailureKind { None, Cancelled, Timeout, Network, Auth, NotFound, DiskFull, Other };
+
+static FailureKind classifyFailure(const JobResult &r)
+{
+    if(r.ok) return FailureKind::None;
+    if(r.cancelled) return FailureKind::Cancelled;
+    if(r.timedOut) return FailureKind::Timeout;
+    const QString e = r.err.toLower();
+    auto any = [&e](std::initializer_list<const char *> needles){
+        for(const char *n : needles) if(e.contains(QLatin1String(n))) return true;
+        return false;
+    };
+    if(any({"no space left on device", "disk quota exceeded"})) return FailureKind::DiskFull;
+    if(any({"permission denied", "authentication failed", "could not read username", "host key verification failed"}))
+        return FailureKind::Auth;
+    if(any({"repository not found", "does not appear to be a git repository"})) return FailureKind::NotFound;
+    if(any({"could not resolve host", "connection timed out", "operation timed out", "connection reset", "connection refused",
+            "connection closed by", "network is unreachable", "early eof", "the remote end hung up unexpectedly",
+            "rpc failed", "unexpected disconnect", "broken pipe", "transfer closed", "ssh: connect to host",
+            "kex_exchange_identification", "index-pack failed", "ssl_read", "gnutls"}))
+        return FailureKind::Network;
+    return FailureKind::Other;
+}
+
+static QString failureName(FailureKind k)
+{
+    switch(k){
+    case FailureKind::None: return "ok";
+    case FailureKind::Cancelled: return "cancelled";
+    case FailureKind::Timeout: return "timeout";
+    case FailureKind::Network: return "network";
+    case FailureKind::Auth: return "authentication";
+    case FailureKind::NotFound: return "not found";
+    case FailureKind::DiskFull: return "disk full";
+    case FailureKind::Other: break;
+    }
+    return "failed";
+}
+
+// Exponential backoff with jitter: retry n waits a random time between half
+// and all of min(maxDelayMs, baseDelayMs * 2^(n-1)), so many repositories
+// failing together do not hammer the server in lockstep.
+struct RetryPolicy {
+    int attempts = 5;           // including the first
+    int baseDelayMs = 2000;
+    int maxDelayMs = 60000;
+
+    static bool retryable(FailureKind k){ return k==FailureKind::Network || k==FailureKind::Timeout; }
+
+    int delayMs(int retry) const
+    {
+        const int cap = int(qMin<qint64>(maxDelayMs, qint64(baseDelayMs) << qMin(retry-1, 20)));
+        return cap/2 + int(QRandomGenerator::global()->bounded(cap/2 + 1));
+    }
+};
+
+// Runs `attempt` until it succeeds, fails for a reason retrying cannot fix, or
+// runs out of attempts; then reports the last result. Deletes itself.
+class Retry : public QObject {
+public:
+    typedef std::function<void(int attempt, GitJob::Callback done)> Attempt;
+    typedef std::function<void(int retry, int delayMs, const JobResult &failed)> Notify;
+
+    static void run(QObject *parent, const RetryPolicy &policy, Attempt attempt, GitJob::Callback done, Notify retrying=nullptr)
+    {
+        (new Retry(parent, policy, attempt, done, retrying))->next();
+    }
+
+    // Cancel All: one waiting out its backoff finishes at once as cancelled, one with an
+    // attempt under way finishes with that attempt instead of starting another.
+    static void cancelAll()
+    {
+        for(Retry *r : QSet<Retry*>(live)) if(live.contains(r)) r->cancel();
+    }
+
+private:
+    Retry(QObject *parent, const RetryPolicy &policy, Attempt attempt, GitJob::Callback done, Notify retrying)
+        : QObject(parent), policy(policy), attempt(attempt), done(done), retrying(retrying), backoff(new QTimer(this))
+    {
+        backoff->setSingleShot(true);
+        connect(backoff, &QTimer::timeout, this, &Retry::next);
+        live.insert(this);
+    }
+    ~Retry() override { live.remove(this); }
+
+    static QSet<Retry*> live;
+    RetryPolicy policy;
+    Attempt attempt;
+    GitJob::Callback done;
+    Notify retrying;
+    QTimer *backoff;
+    int n = 0;
+    bool cancelled = false;
+
+    void next()
+    {
+        ++n;
+        attempt(n, [this](const JobResult &res){
+            JobResult r = res;
+            if(cancelled && !r.ok) r.cancelled = true;
+            if(r.ok || cancelled || n>=policy.attempts || !RetryPolicy::retryable(classifyFailure(r))){
+                finish(r);
+                return;
+            }
+            const int delay = policy.delayMs(n);
+            if(retrying) retrying(n, delay, r);
+            backoff->start(delay);
+        });
+    }
+
+    void cancel()
+    {
+        cancelled = true;
+        if(!backoff->isActive()) return;
+        backoff->stop();
+        JobResult r;
+        r.cancelled = true;
+        r.err = "Cancelled";
+        finish(r);
+    }
+
+    void finish(const JobResult &r)
+    {
+        live.remove(this);
+        done(r);
+        deleteLater();
+    }
+};
+
+QSet<Retry*> Retry::live;
+
+//=========================== PIPELINES ==================================
+struct PipelineContext {
+    QString repo;
+    QMap<QString, JobResult> results;   // by step id, for steps finished so far
+};
+
+// One step of a pipeline: either a git command run in the repository, or a custom
+// asynchronous action that reports through `done`.
+struct PipelineStep {
+    QString id;
+    QStringList deps;
+    std::function<QStringList(const PipelineContext &)> args;
+    std::function<void(const PipelineContext &, GitJob::Callback done)> run;
+    int timeoutMs = 120000;
+    bool stream = false;
+    bool readOnly = false;
+    JobPriority priority = JobPriority::Normal;
+    int attempts = 1;       // > 1: network failures and timeouts retry with backoff (git steps)
+
+    static PipelineStep git(const QString &id, const QStringList &args, const QStringList &deps=QStringList())
+    {
+        PipelineStep s;
+        s.id = id;
+        s.deps = deps;
+        s.args = [args](const PipelineContext &){ return args; };
+        return s;
+    }
+
+    static PipelineStep custom(const QString &id, std::function<void(const PipelineContext &, GitJob::Callback)> run,
+                               const QStringList &deps=QStringList())
+    {
+        PipelineStep s;
+        s.id = id;
+        s.deps = deps;
+        s.run = run;
+        return s;
+    }
+
+    PipelineStep &streamed(){ stream = true; return *this; }
+};
+
+struct PipelineResult {
+    QString repo;
+    bool ok = false;
+    bool cancelled = false;
+    QMap<QString, JobResult> results;
+    QStringList failed;     // step ids that failed or were cancelled
+    QStringList skipped;    // step ids not run because a dependency failed
+};
+
+// Runs a DAG of steps on one repository: a step starts as soon as all its
+// dependencies succeeded, independent steps run concurrently, and a failure
+// skips everything downstream of it. Deletes itself when finished.
+class Pipeline : public QObject {
+    Q_OBJECT
+public:
+    Pipeline(JobPool *jobs, const QString &repo, const QList<PipelineStep> &steps, QObject *parent=nullptr)
+        : QObject(parent), jobs(jobs), steps(steps)
+    {
+        ctx.repo = repo;
+        for(const PipelineStep &s : steps) state[s.id] = Waiting;
+    }
+
+    void start(){ advance(); }
+
+    // Same steps on every repository at once; `each` fires per repository, `all` once at the end.
+    static void runAll(JobPool *jobs, const QStringList &repos, const QList<PipelineStep> &steps, QObject *parent,
+                       std::function<void(const PipelineResult &)> each,
+                       std::function<void(const QList<PipelineResult> &)> all)
+    {
+        auto results = std::make_shared<QList<PipelineResult>>();
+        const int total = repos.size();
+        for(const QString &repo : repos){
+            auto *p = new Pipeline(jobs, repo, steps, parent);
+            connect(p, &Pipeline::finished, parent, [results, total, each, all](const PipelineResult &r){
+                results->append(r);
+                if(each) each(r);
+                if(results->size()==total && all) all(*results);
+            });
+            p->start();
+        }
+        if(total==0 && all) all(*results);
+    }
+
+signals:
+    void finished(const PipelineResult &r);
+
+private:
+    enum State { Waiting, Running, Succeeded, Failed, Skipped };
+    JobPool *jobs;
+    QList<PipelineStep> steps;
+    QMap<QString, State> state;
+    PipelineContext ctx;
+    bool done = false;
+
+    void advance()
+    {
+        bool changed = true;
+        while(changed){
+            changed = false;
+            for(const PipelineStep &s : steps){
+                if(state[s.id]!=Waiting) continue;
+                bool ready = true, blocked = false;
+                for(const QString &d : s.deps){
+                    State ds = state.value(d, Failed);
+                    if(ds==Failed || ds==Skipped) blocked = true;
+                    else if(ds!=Succeeded) ready = false;
+                }
+                if(blocked){ state[s.id] = Skipped; changed = true; }
+                else if(ready){ launch(s); changed = true; }
+            }
+        }
+        for(State st : state) if(st==Waiting || st==Running) return;
+        finish();
+    }
+
+    void launch(const PipelineStep &s)
+    {
+        state[s.id] = Running;
+        const QString id = s.id;
+        GitJob::Callback done = [this, id](const JobResult &r){
+            ctx.results[id] = r;
+            state[id] = r.ok ? Succeeded : Failed;
+            advance();
+        };
+        if(s.run){ s.run(ctx, done); return; }
+        const QStringList args = QStringList{"-C", ctx.repo} + s.args(ctx);
+        auto submit = [this, s, args](int, GitJob::Callback cb){
+            GitJob *job = jobs->submit("git", args, s.timeoutMs, cb);
+            job->stream = s.stream;
+            job->readOnly = s.readOnly;
+            job->priority = s.priority;
+        };
+        if(s.attempts<=1){ submit(1, done); return; }
+        RetryPolicy policy;
+        policy.attempts = s.attempts;
+        Retry::run(this, policy, submit, done);
+    }
+
+    void finish()
+    {
+        if(done) return;
+        done = true;
+        PipelineResult r;
+        r.repo = ctx.repo;
+        r.results = ctx.results;
+        for(auto it = state.constBegin(); it!=state.constEnd(); ++it){
+            if(it.value()==Failed) r.failed << it.key();
+            if(it.value()==Skipped) r.skipped << it.key();
+        }
+        for(const JobResult &jr : ctx.results) if(jr.cancelled) r.cancelled = true;
+        r.ok = r.failed.isEmpty() && r.skipped.isEmpty();
+        emit finished(r);
+        deleteLater();
+    }
+};
+
+//=========================== PERSISTENT HELPERS =========================
+// Resolves the git dir of a working tree, following "gitdir:" files (worktrees, submodules).
+static QString gitDirOf(const QString &repo)
+{
+    QString dotGit = QDir(repo).filePath(".git");
+    QFileInfo fi(dotGit);
+    if(!fi.isFile()) return dotGit;
+    QFile f(dotGit);
+    if(!f.open(QIODevice::ReadOnly)) return dotGit;
+    QString line = QString::fromUtf8(f.readLine()).trimmed();
+    if(!line.startsWith("gitdir:")) return dotGit;
+    QString dir = line.mid(7).trimmed();
+    return QFileInfo(dir).isRelative() ? QDir(repo).filePath(dir) : dir;
+}
+
+// Current branch name straight from HEAD, without spawning git. Empty when detached.
+static QString readHeadBranch(const QString &repo)
 {
-    QProcess proc;
-    proc.start(program, args);
-    if (!proc.waitForStarted(10000)) { stderrOut = "Failed to start"; return false; }
-    if (!proc.waitForFinished(timeoutMs)) { proc.kill(); stderrOut = "Timeout"; return false; }
-    stdoutOut = proc.readAllStandardOutput();
-    stderrOut = proc.readAllStandardError();
-    return proc.exitCode() == 0;
+    QFile f(QDir(gitDirOf(repo)).filePath("HEAD"));
+    if(!f.open(QIODevice::ReadOnly)) return QString();
+    QString head = QString::fromUtf8(f.readLine()).trimmed();
+    if(!head.startsWith("ref: refs/heads/")) return QString();
+    return head.mid(16);
 }
 
+// Where refs, objects and FETCH_HEAD live: linked worktrees share the main git dir.
+static QString commonGitDirOf(const QString &repo)
+{
+    const QString gitDir = gitDirOf(repo);
+    QFile commonFile(gitDir + "/commondir");
+    if(!commonFile.open(QIODevice::ReadOnly)) return gitDir;
+    return QDir(gitDir).absoluteFilePath(QString::fromUtf8(commonFile.readAll()).trimmed());
+}
+
+// When the repository last fetched (FETCH_HEAD is rewritten by every fetch and pull); invalid if never.
+static QDateTime lastFetchTime(const QString &repo)
+{
+    QFileInfo fi(commonGitDirOf(repo) + "/FETCH_HEAD");
+    return fi.exists() ? fi.lastModified() : QDateTime();
+}
+
+// A ref's commit straight from the ref files, without spawning git: "HEAD" or a full
+// ref name, symbolic refs followed. "ref: <name>" while unborn, empty when missing.
+static QString readRef(const QString &repo, const QString &name)
+{
+    const QString gitDir = gitDirOf(repo);
+    const QString common = commonGitDirOf(repo);
+    QString ref = name;
+    for(int depth=0; depth<5; ++depth){
+        QFile loose((ref=="HEAD" ? gitDir : common) + "/" + ref);
+        if(loose.open(QIODevice::ReadOnly)){
+            const QString v = QString::fromUtf8(loose.readLine()).trimmed();
+            if(!v.startsWith("ref: ")) return v;
+            ref = v.mid(5);
+            continue;
+        }
+        QFile packed(common + "/packed-refs");
+        if(packed.open(QIODevice::ReadOnly)){
+            const QByteArray suffix = " " + ref.toUtf8();
+            for(const QByteArray &line : packed.readAll().split('\n'))
+                if(line.endsWith(suffix)) return QString::fromLatin1(line.left(line.indexOf(' ')));
+        }
+        return ref==name ? QString() : "ref: " + ref;
+    }
+    return QString();
+}
+
+// Tip of an upstream as `git status --branch` names it ("origin/main", or a local branch).
+static QString readUpstream(const QString &repo, const QString &upstream)
+{
+    if(upstream.isEmpty()) return QString();
+    const QString remote = readRef(repo, "refs/remotes/" + upstream);
+    return remote.isEmpty() ? readRef(repo, "refs/heads/" + upstream) : remote;
+}
+
+struct ObjectInfo {
+    bool ok = false;
+    QString oid;
+    QString type;
+    qint64 size = 0;
+};
+
+// One long-lived `git cat-file --batch-check` process answering queries over its pipe.
+class CatFileSession : public QObject {
+    Q_OBJECT
+public:
+    typedef std::function<void(const ObjectInfo &)> Callback;
+
+    CatFileSession(const QString &repo, QObject *parent=nullptr) : QObject(parent), repo(repo) {}
+    ~CatFileSession() override { if(proc) proc->disconnect(this); }
+
+    qint64 lastUsed = 0;
+
+    void query(const QString &rev, Callback cb)
+    {
+        lastUsed = QDateTime::currentMSecsSinceEpoch();
+        if(rev.contains('\n')){ cb(ObjectInfo()); return; }
+        pending.append({rev, cb});
+        if(!proc) launch();
+        if(proc) proc->write(rev.toUtf8() + "\n");
+    }
+
+    bool isIdle() const { return pending.isEmpty(); }
+
+    // No more queries: the helper answers what it was already asked, exits on EOF and
+    // the session deletes itself. Never blocks, and is safe from inside a callback.
+    void retire()
+    {
+        if(!proc){ failPending(); deleteLater(); return; }
+        retired = true;
+        proc->closeWriteChannel();
+        QTimer::singleShot(5000, this, [this](){ if(proc) proc->kill(); });
+    }
+
+private:
+    struct Pending { QString rev; Callback cb; };
+    QString repo;
+    QProcess *proc = nullptr;
+    QByteArray buf;
+    QList<Pending> pending;
+    bool retired = false;
+
+    void launch()
+    {
+        proc = new QProcess(this);
+        connect(proc, &QProcess::readyReadStandardOutput, this, [this](){
+            buf += proc->readAllStandardOutput();
+            parse();
+        });
+        auto died = [this](){
+            proc->disconnect(this);
+            proc->deleteLater();
+            proc = nullptr;
+            failPending();
+            if(retired) deleteLater();
+        };
+        connect(proc, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished), this, died);
+        connect(proc, &QProcess::errorOccurred, this, [died](QProcess::ProcessError e){
+            if(e==QProcess::FailedToStart) died();
+        });
+        proc->start("git", {"-C", repo, "cat-file", "--batch-check"});
+    }
+
+    void failPending()
+    {
+        buf.clear();
+        QList<Pending> dead = pending;
+        pending.clear();
+        for(const Pending &p : dead) p.cb(ObjectInfo());
+    }
+
+    // Replies come back in request order: "<oid> <type> <size>\n" or "<rev> missing\n".
+    void parse()
+    {
+        while(!pending.isEmpty()){
+            int nl = buf.indexOf('\n');
+            if(nl<0) return;
+            QByteArray header = buf.left(nl);
+            ObjectInfo info;
+            QList<QByteArray> f = header.split(' ');
+            if(f.size()==3 && !header.endsWith(" missing") && !header.endsWith(" ambiguous")){
+                info.ok = true;
+                info.oid = QString::fromLatin1(f[0]);
+                info.type = QString::fromLatin1(f[1]);
+                info.size = f[2].toLongLong();
+            }
+            buf.remove(0, nl + 1);
+            Pending p = pending.takeFirst();
+            p.cb(info);
+        }
+    }
+};
+
+// Per-repository cat-file sessions, closed when idle or when too many repos are open.
+class GitHelperPool : public QObject {
+    Q_OBJECT
+public:
+    GitHelperPool(int maxRepos, QObject *parent=nullptr) : QObject(parent), maxRepos(maxRepos)
+    {
+        auto *reaper = new QTimer(this);
+        connect(reaper, &QTimer::timeout, this, &GitHelperPool::reap);
+        reaper->start(30000);
+    }
+
+    // Object id/type/size for any revision ("HEAD", "origin/main", "HEAD:path").
+    void resolve(const QString &repo, const QString &rev, CatFileSession::Callback cb){ session(repo)->query(rev, cb); }
+
+    // Drop sessions after operations that rewrite refs or packs underneath them.
+    void invalidate(const QString &repo)
+    {
+        if(CatFileSession *s = sessions.take(repo)) s->retire();
+    }
+
+private:
+    QMap<QString, CatFileSession*> sessions;
+    int maxRepos;
+
+    CatFileSession *session(const QString &repo)
+    {
+        if(!sessions.contains(repo) && sessions.size()>=maxRepos) evictOldest();
+        CatFileSession *&s = sessions[repo];
+        if(!s) s = new CatFileSession(repo, this);
+        return s;
+    }
+
+    void evictOldest()
+    {
+        QString oldest; qint64 t = 0;
+        for(auto it = sessions.constBegin(); it!=sessions.constEnd(); ++it){
+            if(!it.value()->isIdle()) continue;
+            if(oldest.isEmpty() || it.value()->lastUsed<t){ oldest = it.key(); t = it.value()->lastUsed; }
+        }
+        if(!oldest.isEmpty()) invalidate(oldest);
+    }
+
+    void reap()
+    {
+        qint64 cutoff = QDateTime::currentMSecsSinceEpoch() - 120000;
+        for(const QString &repo : sessions.keys())
+            if(sessions[repo]->isIdle() && sessions[repo]->lastUsed<cutoff) invalidate(repo);
+    }
+};
+
+//=========================== BACKENDS ===================================
+struct HeadInfo {
+    bool ok = false;
+    QString branch;     // empty when detached
+    QString oid;        // empty when unborn
+};
+
+struct AheadBehind {
+    bool ok = false;
+    int ahead = 0;
+    int behind = 0;
+    QString error;
+};
+
+// One record of `git status --porcelain=v2`.
+struct StatusEntry {
+    enum Kind { Changed, Renamed, Unmerged, Untracked };
+    Kind kind = Changed;
+    char x = '.';           // index state ('.' = unmodified)
+    char y = '.';           // working tree state
+    QString path;           // untracked directories end in '/'
+    QString origPath;       // rename or copy source
+    QString submodule;      // "N..." for plain files, else "S<commit><modified><untracked>"
+
+    // porcelain v1 style, for display
+    QString text() const
+    {
+        if(kind==Untracked) return "?? " + path;
+        QString t = QString(QChar(x=='.' ? ' ' : x)) + QChar(y=='.' ? ' ' : y) + " " + (origPath.isEmpty() ? path : origPath + " -> " + path);
+        if(submodule.size()==4 && submodule.at(0)=='S'){
+            QStringList what;
+            if(submodule.at(1)=='C') what << "new commits";
+            if(submodule.at(2)=='M') what << "modified content";
+            if(submodule.at(3)=='U') what << "untracked content";
+            t += " (submodule" + (what.isEmpty() ? QString() : ": " + what.join(", ")) + ")";
+        }
+        return t;
+    }
+};
+
+struct BranchStatus {
+    QString oid;            // empty while unborn
+    QString head;           // empty when detached
+    QString upstream;       // empty without one; ahead/behind are relative to it
+    int ahead = 0;
+    int behind = 0;
+};
+
+struct StatusResult {
+    bool ok = false;
+    QList<StatusEntry> entries;
+    BranchStatus branch;
+    QString error;
+};
+
+// `git status --porcelain=v2 -z [--branch]`, parsed in place: records end in NUL, paths
+// are the rest of a record after a fixed number of fields (spaces and all), and a
+// rename record is followed by its source path as a record of its own.
+static StatusResult parsePorcelainV2(const QByteArray &out)
+{
+    StatusResult st;
+    st.ok = true;
+    const char *p = out.constData();
+    const char *end = p + out.size();
+    auto recordEnd = [end](const char *s){
+        const char *nul = static_cast<const char*>(memchr(s, 0, size_t(end-s)));
+        return nul ? nul : end;
+    };
+    auto skipFields = [](const char *s, const char *e, int n){
+        while(n-- > 0 && s<e){
+            const char *sp = static_cast<const char*>(memchr(s, ' ', size_t(e-s)));
+            s = sp ? sp+1 : e;
+        }
+        return s;
+    };
+    auto header = [](const char *s, const char *e, const char *key){
+        const size_t n = strlen(key);
+        return size_t(e-s)>n && memcmp(s, key, n)==0 ? QString::fromUtf8(s+n, int(e-s-n)) : QString();
+    };
+    while(p<end){
+        const char *e = recordEnd(p);
+        const char *next = e<end ? e+1 : end;
+        if(e-p>=2 && p[0]=='#'){
+            QString v;
+            if(!(v = header(p, e, "# branch.oid ")).isEmpty()) st.branch.oid = v=="(initial)" ? QString() : v;
+            else if(!(v = header(p, e, "# branch.head ")).isEmpty()) st.branch.head = v=="(detached)" ? QString() : v;
+            else if(!(v = header(p, e, "# branch.upstream ")).isEmpty()) st.branch.upstream = v;
+            else if(!(v = header(p, e, "# branch.ab ")).isEmpty()){
+                st.branch.ahead = v.section(' ', 0, 0).mid(1).toInt();
+                st.branch.behind = v.section(' ', 1, 1).mid(1).toInt();
+            }
+        } else if(e-p>=10 && (p[0]=='1' || p[0]=='2' || p[0]=='u')){
+            StatusEntry en;
+            en.kind = p[0]=='1' ? StatusEntry::Changed : p[0]=='2' ? StatusEntry::Renamed : StatusEntry::Unmerged;
+            en.x = p[2];
+            en.y = p[3];
+            en.submodule = QString::fromLatin1(p+5, 4);
+            const char *path = skipFields(p, e, p[0]=='1' ? 8 : p[0]=='2' ? 9 : 10);
+            en.path = QString::fromUtf8(path, int(e-path));
+            if(p[0]=='2' && next<end){
+                const char *e2 = recordEnd(next);
+                en.origPath = QString::fromUtf8(next, int(e2-next));
+                next = e2<end ? e2+1 : end;
+            }
+            st.entries << en;
+        } else if(e-p>=3 && p[0]=='?'){
+            StatusEntry en;
+            en.kind = StatusEntry::Untracked;
+            en.x = en.y = '?';
+            en.path = QString::fromUtf8(p+2, int(e-p-2));
+            st.entries << en;
+        }
+        p = next;
+    }
+    return st;
+}
+
+// Read-only repository queries. Network operations (clone/fetch/pull/push) always go through the CLI.
+class GitBackend {
+public:
+    virtual ~GitBackend() {}
+    virtual QString name() const = 0;
+    // priority: sweeps over many repositories pass Background so clicks stay responsive
+    virtual void status(const QString &repo, std::function<void(const StatusResult &)> cb, JobPriority priority=JobPriority::Interactive) = 0;
+    virtual void head(const QString &repo, std::function<void(const HeadInfo &)> cb) = 0;
+    virtual void aheadBehind(const QString &repo, const QString &upstream, std::function<void(const AheadBehind &)> cb) = 0;
+    virtual void diffFile(const QString &repo, const QString &path, std::function<void(QSharedPointer<OutputBuffer>)> cb) = 0;
+};
+
+class CliBackend : public QObject, public GitBackend {
+public:
+    CliBackend(JobPool *jobs, GitHelperPool *helpers, QObject *parent=nullptr)
+        : QObject(parent), jobs(jobs), helpers(helpers) {}
+
+    QString name() const override { return "git CLI"; }
+
+    void status(const QString &repo, std::function<void(const StatusResult &)> cb, JobPriority priority=JobPriority::Interactive) override
+    {
+        GitJob *job = jobs->submit("git", {"--no-optional-locks", "-C", repo, "status", "--porcelain=v2", "-z", "--branch"}, 20000,
+                                   [cb](const JobResult &r){
+            StatusResult st = r.ok && r.output ? parsePorcelainV2(r.output->bytes()) : StatusResult();
+            st.ok = r.ok;
+            st.error = r.err;
+            cb(st);
+        });
+        job->priority = priority;
+        job->readOnly = true;
+    }
+
+    void head(const QString &repo, std::function<void(const HeadInfo &)> cb) override
+    {
+        QString branch = readHeadBranch(repo);
+        helpers->resolve(repo, "HEAD", [cb, branch](const ObjectInfo &o){
+            HeadInfo h;
+            h.ok = true;
+            h.branch = branch;
+            if(o.ok) h.oid = o.oid;
+            cb(h);
+        });
+    }
+
+    // Equal tips are answered from the cat-file helper; only diverged ones cost a rev-list.
+    void aheadBehind(const QString &repo, const QString &upstream, std::function<void(const AheadBehind &)> cb) override
+    {
+        helpers->resolve(repo, "HEAD", [this, repo, upstream, cb](const ObjectInfo &head){
+            helpers->resolve(repo, upstream, [this, repo, upstream, cb, head](const ObjectInfo &up){
+                if(head.ok && up.ok && head.oid==up.oid){
+                    AheadBehind ab; ab.ok = true; cb(ab);
+                    return;
+                }
+                GitJob *job = jobs->submit("git", {"-C", repo, "rev-list", "--left-right", "--count", upstream+"...HEAD"}, 120000,
+                                           [cb](const JobResult &r){
+                    AheadBehind ab;
+                    QStringList parts = r.out.split(QRegExp("[\t ]"),QString::SkipEmptyParts);
+                    if(r.ok && parts.size()>=2){
+                        ab.ok = true;
+                        ab.behind = parts[0].toInt();
+                        ab.ahead = parts[1].toInt();
+                    } else ab.error = r.err;
+                    cb(ab);
+                });
+                job->priority = JobPriority::Interactive;
+                job->readOnly = true;
+            });
+        });
+    }
+
+    void diffFile(const QString &repo, const QString &path, std::function<void(QSharedPointer<OutputBuffer>)> cb) override
+    {
+        GitJob *job = jobs->submit("git", {"-C", repo, "diff", "--", path}, 20000, [cb](const JobResult &r){
+            if(r.err.isEmpty() && r.output){ cb(r.output); return; }
+            // the job's buffer is closed (and maybe mapped): warnings or errors go first in a new one
+            QSharedPointer<OutputBuffer> out(new OutputBuffer());
+            out->append(r.err.toUtf8());
+            if(r.output) out->append(r.output->bytes());
+            out->close();
+            cb(out);
+        });
+        job->priority = JobPriority::Interactive;
+        job->readOnly = true;
+    }
+
+private:
+    JobPool *jobs;
+    GitHelperPool *helpers;
+};
+
+#ifdef HAVE_LIBGIT2
+// In-process queries via libgit2, run on the backend's own thread pool so large repos never
+// block the UI, and so every query has finished before libgit2 shuts down.
+class Libgit2Backend : public QObject, public GitBackend {
+public:
+    explicit Libgit2Backend(QObject *parent=nullptr) : QObject(parent) { git_libgit2_init(); }
+    ~Libgit2Backend() override
+    {
+        pool.clear();
+        pool.waitForDone();
+        git_libgit2_shutdown();
+    }
+
+    QString name() const override { return "libgit2"; }
+
+    void status(const QString &repo, std::function<void(const StatusResult &)> cb, JobPriority priority=JobPriority::Interactive) override
+    {
+        runAsync<StatusResult>([repo](){
+            StatusResult st;
+            git_repository *r = nullptr;
+            if(git_repository_open(&r, QFile::encodeName(repo).constData())!=0){ st.error = lastError(); return st; }
+            git_status_options opts = GIT_STATUS_OPTIONS_INIT;
+            opts.show = GIT_STATUS_SHOW_INDEX_AND_WORKDIR;
+            opts.flags = GIT_STATUS_OPT_INCLUDE_UNTRACKED | GIT_STATUS_OPT_RENAMES_HEAD_TO_INDEX;
+            git_status_list *list = nullptr;
+            if(git_status_list_new(&list, r, &opts)!=0){ st.error = lastError(); git_repository_free(r); return st; }
+            size_t n = git_status_list_entrycount(list);
+            for(size_t i=0; i<n; ++i){
+                const git_status_entry *e = git_status_byindex(list, i);
+                if(e->status==GIT_STATUS_CURRENT || (e->status & GIT_STATUS_IGNORED)) continue;
+                st.entries << statusEntry(e);
+            }
+            st.ok = true;
+            git_status_list_free(list);
+            git_reference *head = nullptr;
+            if(git_repository_head(&head, r)==0){
+                if(const git_oid *oid = git_reference_target(head)) st.branch.oid = oidString(oid);
+                if(!git_repository_head_detached(r)) st.branch.head = QString::fromUtf8(git_reference_shorthand(head));
+                git_reference *up = nullptr;
+                if(git_branch_upstream(&up, head)==0){
+                    st.branch.upstream = QString::fromUtf8(git_reference_shorthand(up));
+                    size_t ahead = 0, behind = 0;
+                    const git_oid *local = git_reference_target(head), *remote = git_reference_target(up);
+                    if(local && remote && git_graph_ahead_behind(&ahead, &behind, r, local, remote)==0){
+                        st.branch.ahead = int(ahead);
+                        st.branch.behind = int(behind);
+                    }
+                    git_reference_free(up);
+                }
+                git_reference_free(head);
+            } else st.branch.head = readHeadBranch(repo);    // unborn branch
+            git_repository_free(r);
+            return st;
+        }, cb, priority);
+    }
+
+    void head(const QString &repo, std::function<void(const HeadInfo &)> cb) override
+    {
+        runAsync<HeadInfo>([repo](){
+            HeadInfo h;
+            git_repository *r = nullptr;
+            if(git_repository_open(&r, QFile::encodeName(repo).constData())!=0) return h;
+            h.ok = true;
+            git_reference *ref = nullptr;
+            if(git_repository_head(&ref, r)==0){
+                if(!git_repository_head_detached(r)) h.branch = QString::fromUtf8(git_reference_shorthand(ref));
+                if(const git_oid *oid = git_reference_target(ref)) h.oid = oidString(oid);
+                git_reference_free(ref);
+            } else h.branch = readHeadBranch(repo);   // unborn branch
+            git_repository_free(r);
+            return h;
+        }, cb);
+    }
+
+    void aheadBehind(const QString &repo, const QString &upstream, std::function<void(const AheadBehind &)> cb) override
+    {
+        runAsync<AheadBehind>([repo, upstream](){
+            AheadBehind ab;
+            git_repository *r = nullptr;
+            if(git_repository_open(&r, QFile::encodeName(repo).constData())!=0){ ab.error = lastError(); return ab; }
+            git_oid local, remote;
+            git_object *up = nullptr;
+            if(git_reference_name_to_id(&local, r, "HEAD")!=0 || git_revparse_single(&up, r, upstream.toUtf8().constData())!=0){
+                ab.error = lastError();
+                git_repository_free(r);
+                return ab;
+            }
+            git_oid_cpy(&remote, git_object_id(up));
+            size_t ahead = 0, behind = 0;
+            if(git_graph_ahead_behind(&ahead, &behind, r, &local, &remote)==0){
+                ab.ok = true;
+                ab.ahead = int(ahead);
+                ab.behind = int(behind);
+            } else ab.error = lastError();
+            git_object_free(up);
+            git_repository_free(r);
+            return ab;
+        }, cb);
+    }
+
+    // Index vs. working tree, like `git diff -- path`.
+    void diffFile(const QString &repo, const QString &path, std::function<void(QSharedPointer<OutputBuffer>)> cb) override
+    {
+        runAsync<QSharedPointer<OutputBuffer>>([repo, path](){
+            QSharedPointer<OutputBuffer> out(new OutputBuffer());
+            git_repository *r = nullptr;
+            if(git_repository_open(&r, QFile::encodeName(repo).constData())!=0){ out->append(lastError().toUtf8()); return out; }
+            QByteArray spec = path.toUtf8();
+            char *specs[] = { spec.data() };
+            git_diff_options opts = GIT_DIFF_OPTIONS_INIT;
+            opts.flags |= GIT_DIFF_DISABLE_PATHSPEC_MATCH;
+            opts.pathspec.strings = specs;
+            opts.pathspec.count = 1;
+            git_diff *diff = nullptr;
+            if(git_diff_index_to_workdir(&diff, r, nullptr, &opts)!=0){
+                out->append(lastError().toUtf8());
+                git_repository_free(r);
+                return out;
+            }
+            git_diff_print(diff, GIT_DIFF_FORMAT_PATCH, [](const git_diff_delta *, const git_diff_hunk *, const git_diff_line *l, void *payload){
+                auto *buf = static_cast<OutputBuffer*>(payload);
+                if(l->origin=='+' || l->origin=='-' || l->origin==' ') buf->append(&l->origin, 1);
+                buf->append(l->content, qint64(l->content_len));
+                return 0;
+            }, out.data());
+            git_diff_free(diff);
+            git_repository_free(r);
+            out->close();
+            return out;
+        }, cb);
+    }
+
+private:
+    QThreadPool pool;
+
+    struct Task : QRunnable {
+        std::function<void()> fn;
+        explicit Task(std::function<void()> fn) : fn(fn) {}
+        void run() override { fn(); }
+    };
+
+    // Queued by priority, so a click is not stuck behind a sweep over every repository.
+    // The result comes back on the GUI thread; `this` outlives the task (see the destructor).
+    template<class T>
+    void runAsync(std::function<T()> work, std::function<void(const T &)> done, JobPriority priority=JobPriority::Interactive)
+    {
+        pool.start(new Task([this, work, done](){
+            const T result = work();
+            QMetaObject::invokeMethod(this, [done, result](){ done(result); }, Qt::QueuedConnection);
+        }), int(JobPriority::Background) - int(priority));    // QThreadPool runs higher numbers first
+    }
+
+    static QString lastError()
+    {
+        const git_error *e = git_error_last();
+        return e && e->message ? QString::fromUtf8(e->message) : QString("libgit2 error");
+    }
+
+    static QString oidString(const git_oid *oid)
+    {
+        char buf[GIT_OID_HEXSZ+1];
+        git_oid_tostr(buf, sizeof(buf), oid);
+        return QString::fromLatin1(buf);
+    }
+
+    static StatusEntry statusEntry(const git_status_entry *e)
+    {
+        unsigned s = e->status;
+        const git_diff_delta *d = e->head_to_index ? e->head_to_index : e->index_to_workdir;
+        StatusEntry en;
+        en.path = QString::fromUtf8(d->new_file.path);
+        if(s & GIT_STATUS_CONFLICTED){ en.kind = StatusEntry::Unmerged; en.x = en.y = 'U'; return en; }
+        if(s==GIT_STATUS_WT_NEW){ en.kind = StatusEntry::Untracked; en.x = en.y = '?'; return en; }
+        char &x = en.x, &y = en.y;
+        if(s & GIT_STATUS_INDEX_NEW) x = 'A';
+        else if(s & GIT_STATUS_INDEX_MODIFIED) x = 'M';
+        else if(s & GIT_STATUS_INDEX_DELETED) x = 'D';
+        else if(s & GIT_STATUS_INDEX_RENAMED) x = 'R';
+        else if(s & GIT_STATUS_INDEX_TYPECHANGE) x = 'T';
+        if(s & GIT_STATUS_WT_MODIFIED) y = 'M';
+        else if(s & GIT_STATUS_WT_DELETED) y = 'D';
+        else if(s & GIT_STATUS_WT_TYPECHANGE) y = 'T';
+        else if(s & GIT_STATUS_WT_RENAMED) y = 'R';
+        if(x=='R'){
+            en.kind = StatusEntry::Renamed;
+            en.origPath = QString::fromUtf8(d->old_file.path);
+        }
+        return en;
+    }
+};
+#endif
+
+//=========================== STATUS WATCHER =============================
+// Keeps one repository's status current from QFileSystemWatcher (inotify) events.
+// Watches are not recursive, so each tracked directory gets its own; a change
+// re-queries just the direct entries of the directories that changed, plus their
+// untracked subdirectories (reported whole, as "?? dir/"). Index or HEAD changes
+// (add, commit, checkout, pull) and bursts over many directories take a full
+// status through the selected backend.
+class StatusWatcher : public QObject {
+    Q_OBJECT
+public:
+    // `useCache`: a still valid cached status may answer first (only for the first one);
+    // the answer says whether it came from the cache, and a fresh status then follows.
+    using FullStatus = std::function<void(const QString &, bool useCache, std::function<void(const StatusResult &, bool cached)>)>;
+    static const int maxDirs = 8000;        // inotify watches are limited per user
+    static const int maxDirtyDirs = 64;     // beyond this a full status is cheaper
+
+    StatusWatcher(JobPool *jobs, const QString &repo, FullStatus fullStatus, QObject *parent=nullptr)
+        : QObject(parent), jobs(jobs), repo(repo), fullStatus(fullStatus),
+          fsw(new QFileSystemWatcher(this)), debounce(new QTimer(this))
+    {
+        gitDir = gitDirOf(repo);
+        debounce->setSingleShot(true);
+        debounce->setInterval(100);
+        connect(debounce, &QTimer::timeout, this, &StatusWatcher::query);
+        connect(fsw, &QFileSystemWatcher::directoryChanged, this, &StatusWatcher::onDirectoryChanged);
+        gitState = readGitState();
+        watchTree();
+        needFull = true;
+        QTimer::singleShot(0, this, [this](){ query(); });     // once changed() is connected
+    }
+
+    bool isWatching() const { return watching; }
+    bool isCurrent() const { return current; }
+    bool isPending() const { return busy || needFull || debounce->isActive(); }
+
+    StatusResult status() const
+    {
+        StatusResult st;
+        st.ok = current;
+        st.entries = entries.values();
+        st.branch = branch;
+        st.error = error;
+        return st;
+    }
+
+    void refresh()
+    {
+        needFull = true;
+        firstStatus = false;
+        query();
+    }
+
+signals:
+    // `incremental`: merged from a partial query rather than a full status
+    void changed(const StatusResult &st, bool incremental);
+
+private:
+    JobPool *jobs;
+    QString repo;
+    QString gitDir;
+    FullStatus fullStatus;
+    QFileSystemWatcher *fsw;
+    QTimer *debounce;
+    QSet<QString> tracked;          // watched directories, relative ("" = top level)
+    QSet<QString> dirty;
+    QMap<QString, StatusEntry> entries;     // by path
+    BranchStatus branch;                    // from the last full status
+    QString gitState;
+    QString error;
+    bool watching = true;           // false when the tree has too many directories
+    bool current = false;
+    bool busy = false;
+    bool needFull = false;
+    bool firstStatus = true;
+
+    void watchTree()
+    {
+        QPointer<StatusWatcher> self(this);
+        GitJob *job = jobs->submit("git", {"-C", repo, "ls-tree", "-d", "-r", "-z", "--name-only", "HEAD"}, 60000, [self](const JobResult &r){
+            if(!self) return;
+            QStringList dirs{QString()};
+            if(r.output) for(const QByteArray &d : r.output->bytes().split('\0')) if(!d.isEmpty()) dirs << QString::fromUtf8(d);
+            self->setWatched(dirs);
+        });
+        job->readOnly = true;
+    }
+
+    void setWatched(const QStringList &dirs)
+    {
+        if(!fsw->directories().isEmpty()) fsw->removePaths(fsw->directories());
+        tracked.clear();
+        watching = dirs.size()<=maxDirs;
+        if(!watching) return;
+        QStringList paths{gitDir};
+        for(const QString &d : dirs){
+            const QString p = d.isEmpty() ? repo : repo + "/" + d;
+            if(!QFileInfo(p).isDir()) continue;     // outside a sparse checkout
+            paths << p;
+            tracked.insert(d);
+        }
+        fsw->addPaths(paths);
+    }
+
+    QString readGitState() const
+    {
+        QFileInfo index(gitDir + "/index");
+        QFile head(gitDir + "/HEAD");
+        head.open(QIODevice::ReadOnly);
+        // a fetch moves the upstream, and with it ahead/behind
+        return QString("%1 %2 %3 %4").arg(index.lastModified().toMSecsSinceEpoch()).arg(index.size())
+                                      .arg(QString::fromUtf8(head.readAll()), readUpstream(repo, branch.upstream));
+    }
+
+    void onDirectoryChanged(const QString &p)
+    {
+        if(p==gitDir){
+            const QString state = readGitState();
+            if(state==gitState) return;     // fetches, lock files, other readers
+            gitState = state;
+            watchTree();                    // directories may have come or gone with the index
+            needFull = true;
+        } else dirty.insert(p==repo ? QString() : p.mid(repo.size()+1));
+        debounce->start();
+    }
+
+    void query()
+    {
+        if(busy) return;    // next() picks the rest up
+        QPointer<StatusWatcher> self(this);
+        if(needFull || dirty.size()>maxDirtyDirs){
+            needFull = false;
+            dirty.clear();
+            busy = true;
+            const bool useCache = firstStatus;
+            firstStatus = false;
+            fullStatus(repo, useCache, [self](const StatusResult &st, bool cached){
+                if(!self) return;
+                // an in-place edit made while unwatched changes no directory mtime
+                if(cached) self->needFull = true;
+                self->busy = false;
+                self->current = st.ok;
+                self->error = st.error;
+                self->entries.clear();
+                for(const StatusEntry &e : st.entries) self->entries.insert(e.path, e);
+                self->branch = st.branch;
+                self->gitState = self->readGitState();
+                emit self->changed(self->status(), false);
+                self->next();
+            });
+            return;
+        }
+        if(dirty.isEmpty()) return;
+        const QStringList dirs = dirty.values();
+        dirty.clear();
+        QStringList args{"--no-optional-locks", "-C", repo, "status", "--porcelain=v2", "-z", "--"};
+        for(const QString &d : dirs){
+            const QString prefix = d.isEmpty() ? QString() : globEscape(d) + "/";
+            args << ":(glob)" + prefix + "*";
+            for(const QString &sub : QDir(d.isEmpty() ? repo : repo + "/" + d).entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden)){
+                const QString rel = d.isEmpty() ? sub : d + "/" + sub;
+                if(!tracked.contains(rel) && rel!=".git") args << ":(glob)" + prefix + globEscape(sub) + "/**";
+            }
+        }
+        busy = true;
+        GitJob *job = jobs->submit("git", args, 20000, [self, dirs](const JobResult &r){
+            if(!self) return;
+            self->busy = false;
+            if(!r.ok){
+                if(r.cancelled) self->current = false;
+                else self->needFull = true;
+                self->next();
+                return;
+            }
+            QSet<QString> changedDirs;
+            for(const QString &d : dirs) changedDirs.insert(d);
+            QStringList stale;
+            for(const QString &p : self->entries.keys()) if(changedDirs.contains(parentDir(p))) stale << p;
+            for(const QString &p : stale) self->entries.remove(p);
+            if(r.output) for(const StatusEntry &e : parsePorcelainV2(r.output->bytes()).entries) self->entries.insert(e.path, e);
+            emit self->changed(self->status(), true);
+            self->next();
+        });
+        job->priority = JobPriority::Interactive;
+        job->readOnly = true;
+    }
+
+    void next()
+    {
+        if(needFull || !dirty.isEmpty()) debounce->start();
+    }
+
+    static QString parentDir(QString p)
+    {
+        if(p.endsWith('/')) p.chop(1);
+        const int slash = p.lastIndexOf('/');
+        return slash<0 ? QString() : p.left(slash);
+    }
+
+    static QString globEscape(QString s)
+    {
+        for(const char *c : {"\\", "*", "?", "["}) s.replace(c, QString("\\") + c);
+        return s;
+    }
+};
+
+//=========================== STATUS CACHE ===============================
+// Last status per repository, valid while the index (mtime, size), HEAD's target and
+// a working-tree fingerprint stay the same. The fingerprint covers the mtimes of the
+// tracked directories (files added, removed or renamed) and of the files the status
+// lists; a clean file edited in place leaves it alone, so entries also expire after
+// maxAgeMs. The index, HEAD and directory parts are read before the status runs
+// (snapshot()), so a change made while it runs leaves the entry stale. Saved as JSON in the clone directory: after a restart, status shows
+// without running git, and only entries that fail validation are recomputed.
+class StatusCache : public QObject {
+    struct Entry {
+        qint64 indexMtime = 0;
+        qint64 indexSize = -1;
+        QString head;
+        QString upstream;       // its tip: ahead/behind change with it
+        QByteArray fingerprint; // tracked directories
+        QByteArray files;       // the files the status lists
+        qint64 at = 0;          // when the status was computed; 0 = expired
+        StatusResult status;
+        QStringList dirs;       // tracked directories at `head`
+        bool sameKey(const Entry &o) const
+        {
+            return indexMtime==o.indexMtime && indexSize==o.indexSize && head==o.head && upstream==o.upstream
+                   && fingerprint==o.fingerprint && files==o.files;
+        }
+    };
+
+public:
+    // Taken right before a status runs; see store().
+    struct Snapshot {
+        Entry key;
+        QString upstreamName;
+    };
+
+    static const int maxDirs = 4000;
+    static const int maxFiles = 1000;
+    static const qint64 maxAgeMs = 15*60*1000;
+
+    StatusCache(JobPool *jobs, QObject *parent=nullptr) : QObject(parent), jobs(jobs), saveTimer(new QTimer(this))
+    {
+        saveTimer->setSingleShot(true);
+        saveTimer->setInterval(2000);
+        connect(saveTimer, &QTimer::timeout, this, &StatusCache::save);
+    }
+    ~StatusCache() override { if(saveTimer->isActive()) save(); }
+
+    // <baseDir>/.git-manager/status-cache.json, by repository name
+    void load(const QString &baseDir)
+    {
+        if(saveTimer->isActive()) save();
+        base = baseDir;
+        entries.clear();
+        QFile f(file());
+        if(!f.open(QIODevice::ReadOnly)) return;
+        const QJsonObject all = QJsonDocument::fromJson(f.readAll()).object();
+        for(auto it = all.begin(); it!=all.end(); ++it){
+            const QJsonObject o = it.value().toObject();
+            Entry e;
+            e.indexMtime = qint64(o.value("indexMtime").toDouble());
+            e.indexSize = qint64(o.value("indexSize").toDouble());
+            e.head = o.value("head").toString();
+            e.upstream = o.value("upstream").toString();
+            e.fingerprint = o.value("fingerprint").toString().toLatin1();
+            e.files = o.value("files").toString().toLatin1();
+            e.at = qint64(o.value("at").toDouble());
+            for(const QJsonValue &v : o.value("entries").toArray()){
+                const QJsonArray a = v.toArray();   // [kind, "XY", path, origPath, submodule]
+                StatusEntry en;
+                en.kind = StatusEntry::Kind(a.at(0).toInt());
+                const QByteArray xy = a.at(1).toString().toLatin1();
+                if(xy.size()==2){ en.x = xy.at(0); en.y = xy.at(1); }
+                en.path = a.at(2).toString();
+                en.origPath = a.at(3).toString();
+                en.submodule = a.at(4).toString();
+                e.status.entries << en;
+            }
+            const QJsonObject b = o.value("branch").toObject();
+            e.status.branch.oid = b.value("oid").toString();
+            e.status.branch.head = b.value("head").toString();
+            e.status.branch.upstream = b.value("upstream").toString();
+            e.status.branch.ahead = b.value("ahead").toInt();
+            e.status.branch.behind = b.value("behind").toInt();
+            e.status.ok = true;
+            for(const QJsonValue &v : o.value("dirs").toArray()) e.dirs << v.toString();
+            entries[QDir(base).filePath(it.key())] = e;
+        }
+    }
+
+    // The cached status (ok is false without one); `valid` tells whether it still
+    // matches the repository.
+    StatusResult lookup(const QString &repo, bool *valid=nullptr) const
+    {
+        if(valid) *valid = false;
+        if(!entries.contains(repo)) return StatusResult();
+        const Entry e = entries.value(repo);
+        if(valid) *valid = QDateTime::currentMSecsSinceEpoch() - e.at < maxAgeMs
+                           && keyOf(repo, e.dirs, e.status.branch.upstream, e.status.entries).sameKey(e);
+        return e.status;
+    }
+
+    Snapshot snapshot(const QString &repo) const
+    {
+        const Entry known = entries.value(repo);
+        Snapshot s;
+        s.key = keyOf(repo, known.dirs, known.status.branch.upstream, QList<StatusEntry>());
+        s.key.dirs = known.dirs;
+        s.upstreamName = known.status.branch.upstream;
+        return s;
+    }
+
+    // A status just computed. With `before`, the entry keeps the snapshot's index, HEAD,
+    // upstream and directory stamps; only the listed files are stamped now. Without it
+    // the whole key is read now, which is for the watcher: it sees any later change.
+    // Tracked directories are listed again only when HEAD moved; such an entry, stamped
+    // after its status, starts out expired when a snapshot was asked for.
+    void store(const QString &repo, const StatusResult &st, const Snapshot *before=nullptr)
+    {
+        if(!st.ok) return;
+        const QString head = readRef(repo, "HEAD");
+        if(entries.contains(repo) && entries[repo].head==head){
+            const QStringList dirs = entries[repo].dirs;
+            Entry e = keyOf(repo, dirs, st.branch.upstream, st.entries);
+            bool fresh = true;
+            if(before){
+                fresh = before->key.head==head && before->key.dirs==dirs && before->upstreamName==st.branch.upstream;
+                e.indexMtime = before->key.indexMtime;
+                e.indexSize = before->key.indexSize;
+                e.head = before->key.head;
+                e.upstream = before->key.upstream;
+                e.fingerprint = before->key.fingerprint;
+            }
+            put(repo, e, dirs, st, fresh);
+            return;
+        }
+        QPointer<StatusCache> self(this);
+        const bool fresh = !before;
+        GitJob *job = jobs->submit("git", {"-C", repo, "ls-tree", "-d", "-r", "-z", "--name-only", "HEAD"}, 60000, [self, repo, st, fresh](const JobResult &r){
+            if(!self) return;
+            QStringList dirs{QString()};
+            if(r.output) for(const QByteArray &d : r.output->bytes().split('\0')) if(!d.isEmpty() && dirs.size()<maxDirs) dirs << QString::fromUtf8(d);
+            self->put(repo, keyOf(repo, dirs, st.branch.upstream, st.entries), dirs, st, fresh);
+        });
+        job->readOnly = true;
+    }
+
+    void remove(const QString &repo)
+    {
+        if(entries.remove(repo)) saveTimer->start();
+    }
+
+private:
+    JobPool *jobs;
+    QTimer *saveTimer;
+    QString base;
+    QMap<QString, Entry> entries;   // by repository path
+
+    QString file() const { return QDir(base).filePath(".git-manager/status-cache.json"); }
+
+    void put(const QString &repo, Entry e, const QStringList &dirs, const StatusResult &st, bool fresh)
+    {
+        e.at = fresh ? QDateTime::currentMSecsSinceEpoch() : 0;
+        e.status = st;
+        e.dirs = dirs;
+        entries[repo] = e;
+        saveTimer->start();
+    }
+
+    static Entry keyOf(const QString &repo, const QStringList &dirs, const QString &upstreamName, const QList<StatusEntry> &files)
+    {
+        Entry e;
+        QFileInfo index(QDir(gitDirOf(repo)).filePath("index"));
+        e.indexMtime = index.exists() ? index.lastModified().toMSecsSinceEpoch() : 0;
+        e.indexSize = index.exists() ? index.size() : -1;
+        e.head = readRef(repo, "HEAD");
+        e.upstream = readUpstream(repo, upstreamName);
+        QCryptographicHash h(QCryptographicHash::Sha1);
+        auto add = [&h, &repo](const QString &rel){
+            QFileInfo fi(rel.isEmpty() ? repo : repo + "/" + rel);
+            QByteArray stamp = QByteArray::number(fi.exists() ? fi.lastModified().toMSecsSinceEpoch() : -1);
+            stamp += ' ';
+            stamp += QByteArray::number(fi.size());
+            stamp += '\n';
+            h.addData(stamp);
+        };
+        for(const QString &d : dirs) add(d);
+        e.fingerprint = h.result().toHex();
+        h.reset();
+        for(const StatusEntry &en : files.mid(0, maxFiles)) add(en.path);
+        e.files = h.result().toHex();
+        return e;
+    }
+
+    void save()
+    {
+        saveTimer->stop();
+        if(base.isEmpty()) return;
+        QJsonObject all;
+        for(const QString &repo : entries.keys()){
+            const Entry &e = entries[repo];
+            QJsonArray list, dirs;
+            for(const StatusEntry &en : e.status.entries){
+                QJsonArray a;
+                a.append(int(en.kind));
+                a.append(QString(QChar(en.x)) + QChar(en.y));
+                a.append(en.path);
+                a.append(en.origPath);
+                a.append(en.submodule);
+                list.append(a);
+            }
+            for(const QString &d : e.dirs) dirs.append(d);
+            QJsonObject branch;
+            branch.insert("oid", e.status.branch.oid);
+            branch.insert("head", e.status.branch.head);
+            branch.insert("upstream", e.status.branch.upstream);
+            branch.insert("ahead", e.status.branch.ahead);
+            branch.insert("behind", e.status.branch.behind);
+            QJsonObject o;
+            o.insert("indexMtime", double(e.indexMtime));
+            o.insert("indexSize", double(e.indexSize));
+            o.insert("head", e.head);
+            o.insert("upstream", e.upstream);
+            o.insert("fingerprint", QString::fromLatin1(e.fingerprint));
+            o.insert("files", QString::fromLatin1(e.files));
+            o.insert("at", double(e.at));
+            o.insert("entries", list);
+            o.insert("branch", branch);
+            o.insert("dirs", dirs);
+            all.insert(QFileInfo(repo).fileName(), o);
+        }
+        QDir().mkpath(QFileInfo(file()).absolutePath());
+        QSaveFile f(file());
+        if(!f.open(QIODevice::WriteOnly)) return;
+        f.write(QJsonDocument(all).toJson(QJsonDocument::Compact));
+        f.commit();
+    }
+};
+
+//=========================== CLONE PROFILES =============================
+// Parallel checkout for clones and checkouts made here (git 2.32+; ignored before).
+static QString checkoutWorkers(){ return QString::number(qBound(1, QThread::idealThreadCount(), 16)); }
+
+// How much history and content a clone fetches. The profile is written into the
+// clone's own config (gitmanager.profile, gitmanager.depth) so later fetches keep to it.
+struct CloneProfile {
+    enum Kind { Full, Shallow, Blobless, Treeless, SingleBranch };
+    Kind kind = Full;
+    int depth = 1;          // Shallow only
+
+    static QStringList names(){ return {"full", "shallow", "blobless", "treeless", "single-branch"}; }
+    QString name() const { return names().value(kind); }
+    QString label() const { return kind==Shallow ? QString("shallow (depth %1)").arg(depth) : name(); }
+
+    static CloneProfile fromName(const QString &name, int depth=1)
+    {
+        CloneProfile p;
+        p.kind = Kind(qMax(0, names().indexOf(name)));
+        p.depth = qMax(1, depth);
+        return p;
+    }
+
+    // Parses `git config --get-regexp ^gitmanager\.` output; no entries = full clone.
+    static CloneProfile fromConfig(const QString &out)
+    {
+        QString name = "full";
+        int depth = 1;
+        for(const QString &line : out.split('\n', QString::SkipEmptyParts)){
+            QString key = line.section(' ', 0, 0), value = line.section(' ', 1).trimmed();
+            if(key=="gitmanager.profile") name = value;
+            else if(key=="gitmanager.depth") depth = value.toInt();
+        }
+        return fromName(name, depth);
+    }
+
+    QStringList cloneArgs() const
+    {
+        QStringList a;
+        switch(kind){
+        case Full: break;
+        case Shallow: a << "--depth" << QString::number(depth); break;     // implies --single-branch
+        case Blobless: case Treeless: a << "--filter=" + filter(); break;
+        case SingleBranch: a << "--single-branch"; break;
+        }
+        a << "--config" << "gitmanager.profile=" + name();
+        a << "--config" << "checkout.workers=" + checkoutWorkers();
+        if(kind==Shallow) a << "--config" << QString("gitmanager.depth=%1").arg(depth);
+        return a;
+    }
+
+    QString filter() const { return kind==Blobless ? "blob:none" : kind==Treeless ? "tree:0" : QString(); }
+
+    // Shallow and partial clones are small already; filling the shared object
+    // cache for them would download exactly what they avoid.
+    bool usesObjectCache() const { return kind==Full || kind==SingleBranch; }
+
+    // Partial-clone filters and single-branch refspecs are kept by git itself;
+    // only the depth has to be passed again.
+    QStringList fetchArgs() const
+    {
+        return kind==Shallow ? QStringList{"--depth", QString::number(depth)} : QStringList();
+    }
+};
+
+// What one clone will do, and why.
+struct ClonePlan {
+    CloneProfile profile;
+    bool objectCache = false;
+    QString branch;         // default branch, if known
+    QString reason;
+};
+
+//=========================== RESUMABLE CLONES ===========================
+// A clone that survives dropped connections: git init + fetch instead of git
+// clone, with history brought in by --depth 1 and then growing --deepen steps,
+// so every completed step stays on disk. Each run carries on from what is there
+// (.git/gitmanager-partial marks an unfinished clone); retrying after a failure
+// never starts from zero. Deletes itself.
+class ResumableClone : public QObject {
+public:
+    static bool isPartial(const QString &target){ return QFileInfo::exists(QDir(target).filePath(".git/gitmanager-partial")); }
+
+    // `track` sees every job that talks to the remote; `cache` is the shared object
+    // cache to borrow from, or empty.
+    static void run(JobPool *jobs, const QString &url, const QString &target, const ClonePlan &plan, const QString &cache,
+                    bool dissociate, std::function<void(GitJob *)> track, GitJob::Callback done)
+    {
+        auto *c = new ResumableClone(jobs);
+        c->url = url; c->target = target; c->plan = plan; c->cache = cache;
+        c->dissociate = dissociate; c->track = track; c->done = done;
+        c->branch = plan.branch;
+        c->start();
+    }
+
+private:
+    explicit ResumableClone(JobPool *jobs) : QObject(jobs), jobs(jobs) {}
+
+    JobPool *jobs;
+    QString url, target, cache, branch;
+    ClonePlan plan;
+    bool dissociate = false;
+    std::function<void(GitJob *)> track;
+    GitJob::Callback done;
+    int deepen = 100;
+
+    static constexpr int maxDeepen = 1<<20;
+
+    QString gitPath(const QString &rel) const { return QDir(target).filePath(".git/" + rel); }
+
+    void git(const QStringList &args, std::function<void(const JobResult &)> next, bool remote=false)
+    {
+        GitJob *job = jobs->submit("git", QStringList{"-C", target} + args, 0, [this, next](const JobResult &r){
+            if(r.ok) next(r); else finish(r);
+        }, target);
+        if(remote && track) track(job);
+    }
+
+    void start()
+    {
+        if(QFileInfo::exists(gitPath("HEAD"))){ configure(); return; }
+        QDir(target).removeRecursively();      // leftovers of a killed clone; the directory is ours
+        QDir().mkpath(target);
+        git({"init"}, [this](const JobResult &){ configure(); });
+    }
+
+    void configure()
+    {
+        QFile marker(gitPath("gitmanager-partial"));
+        if(marker.open(QIODevice::WriteOnly)) marker.write(url.toUtf8() + "\n");
+        marker.close();
+        QString refspec = "+refs/heads/*:refs/remotes/origin/*";
+        if(plan.profile.kind==CloneProfile::SingleBranch && !branch.isEmpty())
+            refspec = QString("+refs/heads/%1:refs/remotes/origin/%1").arg(branch);
+        QList<QStringList> cmds{{"config", "remote.origin.url", url}, {"config", "remote.origin.fetch", refspec},
+                                {"config", "gitmanager.profile", plan.profile.name()},
+                                {"config", "checkout.workers", checkoutWorkers()}};
+        if(plan.profile.kind==CloneProfile::Shallow) cmds << QStringList{"config", "gitmanager.depth", QString::number(plan.profile.depth)};
+        if(!plan.profile.filter().isEmpty())
+            cmds << QStringList{"config", "remote.origin.promisor", "true"}
+                 << QStringList{"config", "remote.origin.partialclonefilter", plan.profile.filter()};
+        if(!cache.isEmpty() && QDir(cache).exists()){
+            QDir().mkpath(gitPath("objects/info"));
+            QFile alt(gitPath("objects/info/alternates"));
+            if(alt.open(QIODevice::WriteOnly)) alt.write(QDir(cache).filePath("objects").toUtf8() + "\n");
+        }
+        sequence(cmds, [this](){ fetchHistory(); });
+    }
+
+    void sequence(QList<QStringList> cmds, std::function<void()> next)
+    {
+        if(cmds.isEmpty()){ next(); return; }
+        QStringList first = cmds.takeFirst();
+        git(first, [this, cmds, next](const JobResult &){ sequence(cmds, next); });
+    }
+
+    // Our own marker: git creates FETCH_HEAD when a fetch starts, not when it succeeds.
+    void markFetched()
+    {
+        QFile marker(gitPath("gitmanager-fetched"));
+        if(marker.open(QIODevice::WriteOnly)) marker.close();
+    }
+
+    void fetchHistory()
+    {
+        const bool fetched = QFileInfo::exists(gitPath("gitmanager-fetched"));
+        if(plan.profile.kind==CloneProfile::Shallow){
+            if(fetched) checkout();
+            else git({"fetch", "--progress", "--depth", QString::number(plan.profile.depth), "origin"},
+                     [this](const JobResult &){ markFetched(); checkout(); }, true);
+            return;
+        }
+        if(!fetched){
+            git({"fetch", "--progress", "--depth", "1", "origin"}, [this](const JobResult &){ markFetched(); fetchHistory(); }, true);
+            return;
+        }
+        if(!QFileInfo::exists(gitPath("shallow"))){ checkout(); return; }   // git drops it once history is complete
+        git({"fetch", "--progress", "--deepen", QString::number(deepen), "origin"}, [this](const JobResult &){
+            deepen = qMin(deepen*2, maxDeepen);
+            fetchHistory();
+        }, true);
+    }
+
+    void checkout()
+    {
+        if(branch.isEmpty()){
+            git({"ls-remote", "--symref", "origin", "HEAD"}, [this](const JobResult &r){
+                QRegExp rx("ref: refs/heads/(\\S+)\\s+HEAD");
+                if(rx.indexIn(r.out)<0){ complete(); return; }  // empty repository
+                branch = rx.cap(1);
+                checkout();
+            }, true);
+            return;
+        }
+        git({"checkout", "-B", branch, "--track", "origin/" + branch}, [this](const JobResult &){
+            if(cache.isEmpty() || !dissociate){ complete(); return; }
+            git({"repack", "-a", "-d"}, [this](const JobResult &){
+                QFile::remove(gitPath("objects/info/alternates"));
+                complete();
+            });
+        });
+    }
+
+    void complete()
+    {
+        QFile::remove(gitPath("gitmanager-fetched"));
+        QFile::remove(gitPath("gitmanager-partial"));
+        JobResult r;
+        r.ok = true;
+        r.exitCode = 0;
+        finish(r);
+    }
+
+    void finish(const JobResult &r)
+    {
+        if(done) done(r);
+        deleteLater();
+    }
+};
+
+//=========================== SNAPSHOTS ==================================
+// Read-only copy of a repository at one ref, without history. The GitHub tarball
+// is piped from the network straight into `tar -xz`; nothing is stored in between.
+// The reply's read buffer is bounded and reading pauses while tar's stdin is backed
+// up, so a slow disk throttles the download instead of filling memory.
+class SnapshotDownload : public QObject {
+    Q_OBJECT
+public:
+    static constexpr qint64 bufferBytes = 4*1024*1024;
+    static constexpr qint64 chunkBytes = 256*1024;
+
+    SnapshotDownload(QNetworkAccessManager *net, const QNetworkRequest &req, const QString &target, QObject *parent=nullptr)
+        : QObject(parent), net(net), req(req), target(target) {}
+
+    void start()
+    {
+        QDir().mkpath(target);
+        tar = new GroupProcess(this);
+        connect(tar, &QProcess::bytesWritten, this, &SnapshotDownload::pump);
+        connect(tar, &QProcess::errorOccurred, this, [this](QProcess::ProcessError e){
+            if(e==QProcess::FailedToStart) fail("Cannot run tar");
+        });
+        connect(tar, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished), this, [this](int code, QProcess::ExitStatus st){
+            if(st!=QProcess::NormalExit || code!=0){ fail("tar: " + QString::fromUtf8(tar->readAllStandardError()).trimmed()); return; }
+            tarDone = true;     // tar may stop at the end-of-archive marker before the last bytes arrive
+            if(replyDone) succeed();
+        });
+        tar->start("tar", {"-xzf", "-", "--strip-components=1", "-C", target});
+
+        req.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);     // api.github.com -> codeload
+        reply = net->get(req);
+        reply->setReadBufferSize(bufferBytes);
+        connect(reply, &QNetworkReply::readyRead, this, &SnapshotDownload::pump);
+        connect(reply, &QNetworkReply::downloadProgress, this, &SnapshotDownload::progress);
+        connect(reply, &QNetworkReply::finished, this, [this](){
+            if(reply->error()!=QNetworkReply::NoError){ fail(reply->errorString()); return; }
+            replyDone = true;
+            pump();
+            if(tarDone) succeed();
+        });
+    }
+
+    void cancel()
+    {
+        cancelled = true;
+        fail("Cancelled");
+    }
+
+signals:
+    void progress(qint64 received, qint64 total);
+    void finished(const JobResult &r);
+
+private:
+    QNetworkAccessManager *net;
+    QNetworkRequest req;
+    QString target;
+    QNetworkReply *reply = nullptr;
+    GroupProcess *tar = nullptr;
+    bool replyDone = false;
+    bool tarDone = false;
+    bool stdinClosed = false;
+    bool cancelled = false;
+    bool done = false;
+
+    void pump()
+    {
+        if(done) return;
+        if(tarDone){ reply->readAll(); return; }
+        while(reply->bytesAvailable()>0 && tar->bytesToWrite()<bufferBytes)
+            tar->write(reply->read(qMin(reply->bytesAvailable(), chunkBytes)));
+        if(replyDone && reply->bytesAvailable()==0 && !stdinClosed){
+            stdinClosed = true;
+            tar->closeWriteChannel();
+        }
+    }
+
+    void succeed()
+    {
+        JobResult r;
+        r.ok = true;
+        r.exitCode = 0;
+        QFile stamp(QDir(target).filePath(".gitmanager-snapshot"));
+        if(stamp.open(QIODevice::WriteOnly))
+            stamp.write(req.url().toString().toUtf8() + " " + QDateTime::currentDateTimeUtc().toString(Qt::ISODate).toUtf8() + "\n");
+        report(r);
+    }
+
+    void fail(const QString &err)
+    {
+        if(done) return;
+        done = true;        // abort() below emits finished, which would fail a second time
+        JobResult r;
+        r.cancelled = cancelled;
+        r.err = err;
+        if(reply && !reply->isFinished()) reply->abort();
+        if(tar && tar->state()!=QProcess::NotRunning){ tar->disconnect(this); tar->kill(); tar->waitForFinished(1000); }
+        QDir(target).removeRecursively();
+        report(r);
+    }
+
+    void report(const JobResult &r)
+    {
+        done = true;
+        if(reply) reply->deleteLater();
+        emit finished(r);
+        deleteLater();
+    }
+};
+
 class GitHubClient : public QWidget {
     Q_OBJECT
 public:
-    GitHubClient(QWidget *parent=nullptr) : QWidget(parent), net(new QNetworkAccessManager(this))
+    GitHubClient(QWidget *parent=nullptr) : QWidget(parent), net(new QNetworkAccessManager(this)),
+        jobs(new JobPool(qBound(2, QThread::idealThreadCount(), 8), this)),
+        helpers(new GitHelperPool(16, this)), statusCache(new StatusCache(jobs, this))
     {
+        backends << new CliBackend(jobs, helpers, this);
+#ifdef HAVE_LIBGIT2
+        backends << new Libgit2Backend(this);
+#endif
         setupUi();
         connectSignals();
         appendLog("Qt GitHub Client demo (REST API version) started.");
@@ -72,21 +2466,101 @@ private:
     QLineEdit *usernameEdit;
     QPushButton *searchBtn;
     QPushButton *cloneBtn;
+    QPushButton *snapshotBtn;
     QPushButton *chooseDirBtn;
     QPushButton *refreshLocalBtn;
     QPushButton *checkUpdatesBtn;
     QPushButton *pullBtn;
+    QPushButton *worktreeBtn;
     QPushButton *diffBtn;
+    QPushButton *sparseBtn;
+    QPushButton *largeRepoBtn;
     QPushButton *pushBtn;
 
     QListWidget *repoList;
     QListWidget *fileList;
     QPlainTextEdit *diffView;
+    QLabel *diffPageLabel;
+    QPushButton *diffPrevBtn;
+    QPushButton *diffNextBtn;
     QPlainTextEdit *logView;
+    QLabel *headLabel;
+    QLabel *jobStatusLabel;
+    QTabWidget *bottomTabs;
+    QListWidget *jobList;
+    QPlainTextEdit *jobOutput;
+    QPushButton *cancelJobBtn;
+    QPushButton *cancelAllBtn;
+    QTableWidget *cloneTable;
+    QProgressBar *cloneTotalBar;
+    QLabel *cloneTotalLabel;
+    QSpinBox *cloneLimitBox;
+    QCheckBox *objectCacheBox;
+    QCheckBox *dissociateBox;
+    QPushButton *bundleDirBtn;
+    QCheckBox *mirrorBox;
+    QString bundleDir;              // pre-seeded <name>.bundle files; empty = none
+    QSpinBox *budgetBox;            // GB for everything under localBaseDir, 0 = no budget
+    QComboBox *evictKeepBox;
+    QLabel *diskLabel;
+    bool budgetRunning = false;
+    bool budgetRecheck = false;     // settings changed while a check was running
+    QSet<QString> restoring;        // repository names
+    QCheckBox *liveStatusBox;
+    QMap<QString, StatusWatcher*> watchers;     // by path: the selected repository and pinned ones
+    QSet<QString> pinnedRepos;                  // names
+    QTableWidget *usageTable;
+    QPushButton *exportUsageBtn;
+    QTableWidget *dashTable;
+    QLabel *dashLabel;
+    QPushButton *dashRefreshBtn;
+    QMap<QString, QTableWidgetItem*> dashRows;  // name column, by repository name
+    int dashGeneration = 0;                     // results of an earlier refresh are dropped
+    int dashPending = 0;
+
+    QMap<quint64, QListWidgetItem*> jobItems;
+    QMap<quint64, QStringList> jobLines;    // retained output of the last maxJobRecords jobs
+    static const int maxJobRecords = 200;
+    static const int maxJobLines = 2000;
+    static const int maxUsageRows = 5000;
+
+    struct CloneState {
+        int row = 0;
+        double fraction = 0;        // 0..1 over all phases
+        qint64 startedAt = 0;       // ms since epoch, 0 while queued
+        bool done = false;
+        QString failure;            // failureName() of a failed clone
+    };
+    QMap<QString, CloneState> clones;   // current clone batch, by target directory
+    QSet<SnapshotDownload*> snapshots;  // running
+    QList<std::function<void()>> snapshotQueue;     // waiting for a slot (same limit as clones)
+
+    // repoList item data, from the GitHub API.
+    enum RepoRole {
+        SshUrlRole = Qt::UserRole,
+        FullNameRole, SizeKbRole, ForkRole, ArchivedRole, DefaultBranchRole, PushedAtRole
+    };
+    static const qint64 bloblessAboveKb = 512*1024;     // "auto": GitHub's size is in KB
+    // fileList item data
+    enum FileRole { PathRole = Qt::UserRole, OrigPathRole };
+    QElapsedTimer cloneTimer;
+    int clonesFailed = 0;
 
     QString localBaseDir;
     QString token;
     QNetworkAccessManager *net;
+    JobPool *jobs;
+    GitHelperPool *helpers;
+    StatusCache *statusCache;
+    QList<GitBackend*> backends;    // [0] is always the CLI
+    QComboBox *backendBox;
+    QSharedPointer<OutputBuffer> diffOutput;    // diff being paged through
+    QList<qint64> diffPageStarts;               // offsets of the current page and those before it
+    qint64 diffPageEnd = 0;
+    static const qint64 diffPageBytes = 256*1024;
+    QSpinBox *workersBox;
+    QComboBox *cloneProfileBox;     // workspace default
+    QSpinBox *cloneDepthBox;
 
     void setupUi()
     {
@@ -102,62 +2576,631 @@ private:
         top->addWidget(searchBtn);
         top->addWidget(chooseDirBtn);
         top->addWidget(cloneBtn);
+        snapshotBtn = new QPushButton("Snapshot Selected");
+        snapshotBtn->setToolTip("Download the default branch as a tarball and unpack it (read-only, no history)");
+        top->addWidget(snapshotBtn);
+        cloneProfileBox = new QComboBox();
+        cloneProfileBox->addItems(CloneProfile::names());
+        cloneProfileBox->addItem("auto");
+        cloneProfileBox->setToolTip("Default clone profile for this clone directory (right-click a repository to clone with another);\n"
+                                    "auto picks one per repository from its size, fork and archived state");
+        top->addWidget(cloneProfileBox);
+        cloneDepthBox = new QSpinBox();
+        cloneDepthBox->setRange(1, 100000);
+        cloneDepthBox->setPrefix("Depth: ");
+        cloneDepthBox->setEnabled(false);
+        top->addWidget(cloneDepthBox);
+        backendBox = new QComboBox();
+        for(GitBackend *b : backends) backendBox->addItem(b->name());
+        backendBox->setCurrentIndex(backends.size()-1);
+        backendBox->setToolTip("Backend for status, refs, ahead/behind and diffs");
+        top->addWidget(backendBox);
+        workersBox = new QSpinBox();
+        workersBox->setRange(1, 64);
+        workersBox->setValue(jobs->concurrency());
+        workersBox->setPrefix("Workers: ");
+        workersBox->setToolTip("Parallel git processes across repositories (one at a time per repository)");
+        top->addWidget(workersBox);
         main->addLayout(top);
 
         auto *split = new QSplitter(Qt::Horizontal);
 
-        auto *left = new QWidget();
-        auto *ll = new QVBoxLayout(left);
-        repoList = new QListWidget();
-        ll->addWidget(new QLabel("Repositories"));
-        ll->addWidget(repoList);
-        refreshLocalBtn = new QPushButton("Refresh Local");
-        checkUpdatesBtn = new QPushButton("Check Updates");
-        pullBtn = new QPushButton("Pull");
-        ll->addWidget(refreshLocalBtn);
-        ll->addWidget(checkUpdatesBtn);
-        ll->addWidget(pullBtn);
-        split->addWidget(left);
+        auto *left = new QWidget();
+        auto *ll = new QVBoxLayout(left);
+        repoList = new QListWidget();
+        repoList->setSelectionMode(QAbstractItemView::ExtendedSelection);
+        repoList->setContextMenuPolicy(Qt::CustomContextMenu);
+        ll->addWidget(new QLabel("Repositories"));
+        ll->addWidget(repoList);
+        refreshLocalBtn = new QPushButton("Refresh Local");
+        checkUpdatesBtn = new QPushButton("Check Updates");
+        pullBtn = new QPushButton("Pull");
+        ll->addWidget(refreshLocalBtn);
+        ll->addWidget(checkUpdatesBtn);
+        ll->addWidget(pullBtn);
+        worktreeBtn = new QPushButton("Add Worktree");
+        worktreeBtn->setToolTip("Check out another branch of the selected repository in <name>@<branch>, sharing its objects");
+        ll->addWidget(worktreeBtn);
+        split->addWidget(left);
+
+        auto *mid = new QWidget();
+        auto *ml = new QVBoxLayout(mid);
+        fileList = new QListWidget();
+        auto *fileHeader = new QHBoxLayout();
+        headLabel = new QLabel();
+        fileHeader->addWidget(new QLabel("Files"));
+        liveStatusBox = new QCheckBox("Live");
+        liveStatusBox->setToolTip("Watch the selected (and pinned) repositories and update the file list as files change");
+        fileHeader->addWidget(liveStatusBox);
+        fileHeader->addStretch();
+        fileHeader->addWidget(headLabel);
+        ml->addLayout(fileHeader);
+        ml->addWidget(fileList);
+        diffBtn = new QPushButton("Show Diff");
+        ml->addWidget(diffBtn);
+        sparseBtn = new QPushButton("Sparse Checkout...");
+        sparseBtn->setToolTip("Choose which directories of the selected repository are checked out");
+        ml->addWidget(sparseBtn);
+        largeRepoBtn = new QPushButton("Large Repo Mode...");
+        largeRepoBtn->setToolTip("Untracked cache, fsmonitor, index v4 and sparse index for the selected repository");
+        ml->addWidget(largeRepoBtn);
+        split->addWidget(mid);
+
+        auto *right = new QWidget();
+        auto *rl = new QVBoxLayout(right);
+        diffView = new QPlainTextEdit(); diffView->setReadOnly(true);
+        auto *diffHeader = new QHBoxLayout();
+        diffPageLabel = new QLabel();
+        diffPrevBtn = new QPushButton("<"); diffPrevBtn->setEnabled(false);
+        diffNextBtn = new QPushButton(">"); diffNextBtn->setEnabled(false);
+        diffHeader->addWidget(new QLabel("Diff"));
+        diffHeader->addStretch();
+        diffHeader->addWidget(diffPageLabel);
+        diffHeader->addWidget(diffPrevBtn);
+        diffHeader->addWidget(diffNextBtn);
+        rl->addLayout(diffHeader);
+        rl->addWidget(diffView);
+        pushBtn = new QPushButton("Commit & Push");
+        rl->addWidget(pushBtn);
+        split->addWidget(right);
+
+        main->addWidget(split);
+
+        logView = new QPlainTextEdit(); logView->setReadOnly(true);
+        logView->setMaximumBlockCount(5000);
+        auto *logHeader = new QHBoxLayout();
+        jobStatusLabel = new QLabel("Jobs: idle");
+        logHeader->addStretch();
+        logHeader->addWidget(jobStatusLabel);
+        main->addLayout(logHeader);
+
+        bottomTabs = new QTabWidget();
+        bottomTabs->addTab(logView, "Log");
+        auto *jobSplit = new QSplitter(Qt::Horizontal);
+        auto *jobLeft = new QWidget();
+        auto *jl = new QVBoxLayout(jobLeft);
+        jl->setContentsMargins(0,0,0,0);
+        jobList = new QListWidget();
+        jl->addWidget(jobList);
+        auto *jobBtns = new QHBoxLayout();
+        cancelJobBtn = new QPushButton("Cancel");
+        cancelAllBtn = new QPushButton("Cancel All");
+        jobBtns->addWidget(cancelJobBtn);
+        jobBtns->addWidget(cancelAllBtn);
+        jl->addLayout(jobBtns);
+        jobOutput = new QPlainTextEdit(); jobOutput->setReadOnly(true);
+        jobOutput->setMaximumBlockCount(maxJobLines);
+        jobSplit->addWidget(jobLeft);
+        jobSplit->addWidget(jobOutput);
+        jobSplit->setStretchFactor(1, 2);
+        bottomTabs->addTab(jobSplit, "Jobs");
+        auto *clonePane = new QWidget();
+        auto *cl = new QVBoxLayout(clonePane);
+        cl->setContentsMargins(0,0,0,0);
+        auto *cloneHeader = new QHBoxLayout();
+        cloneTotalBar = new QProgressBar();
+        cloneTotalBar->setRange(0, 1000);
+        cloneTotalBar->setTextVisible(false);
+        cloneTotalLabel = new QLabel("No clones");
+        cloneLimitBox = new QSpinBox();
+        cloneLimitBox->setRange(1, 32);
+        cloneLimitBox->setValue(4);
+        cloneLimitBox->setPrefix("Parallel clones: ");
+        cloneHeader->addWidget(cloneTotalBar, 1);
+        cloneHeader->addWidget(cloneTotalLabel);
+        cloneHeader->addWidget(cloneLimitBox);
+        objectCacheBox = new QCheckBox("Shared object cache");
+        objectCacheBox->setToolTip("Fetch into <clone dir>/.git-manager/objects.git and clone with --reference-if-able,\n"
+                                   "so objects shared between repositories (forks) are downloaded and stored once");
+        dissociateBox = new QCheckBox("Dissociate");
+        dissociateBox->setToolTip("Copy borrowed objects into each clone (--dissociate): more disk, but clones no longer depend on the cache");
+        cloneHeader->addWidget(objectCacheBox);
+        cloneHeader->addWidget(dissociateBox);
+        bundleDirBtn = new QPushButton("Bundles: none");
+        bundleDirBtn->setToolTip("Directory of <name>.bundle files: clones start from the bundle and fetch only what is newer");
+        cloneHeader->addWidget(bundleDirBtn);
+        mirrorBox = new QCheckBox("Mirror + worktrees");
+        mirrorBox->setToolTip("Keep a bare repository per repo in .git-manager/mirrors and make each clone a worktree of it:\n"
+                              "one fetch updates every checkout, and more branches cost almost nothing");
+        cloneHeader->addWidget(mirrorBox);
+        cl->addLayout(cloneHeader);
+        auto *diskRow = new QHBoxLayout();
+        budgetBox = new QSpinBox();
+        budgetBox->setRange(0, 100000);
+        budgetBox->setPrefix("Disk budget: ");
+        budgetBox->setSuffix(" GB");
+        budgetBox->setSpecialValueText("Disk budget: off");
+        budgetBox->setToolTip("Everything in the clone directory counts; over budget, the least recently used clean clones are evicted.\n"
+                              "Clones with uncommitted, untracked or ignored files are never evicted.");
+        evictKeepBox = new QComboBox();
+        evictKeepBox->addItems({"bundle", "git dir", "nothing"});
+        evictKeepBox->setToolTip("What an evicted clone keeps in .git-manager/evicted:\n"
+                                 "bundle - all refs and objects in one file (smallest; full and single-branch clones only)\n"
+                                 "git dir - the .git directory as is (fastest restore)\n"
+                                 "nothing - only clones whose commits are all on the remote are evicted");
+        diskLabel = new QLabel("Disk: -");
+        diskRow->addWidget(budgetBox);
+        diskRow->addWidget(new QLabel("Evicted clones keep:"));
+        diskRow->addWidget(evictKeepBox);
+        diskRow->addWidget(diskLabel, 1);
+        cl->addLayout(diskRow);
+        cloneTable = new QTableWidget(0, 4);
+        cloneTable->setHorizontalHeaderLabels({"Repository", "Phase", "Progress", "ETA / Result"});
+        cloneTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        cloneTable->verticalHeader()->setVisible(false);
+        cloneTable->horizontalHeader()->setStretchLastSection(true);
+        cl->addWidget(cloneTable);
+        bottomTabs->addTab(clonePane, "Clones");
+        auto *usagePane = new QWidget();
+        auto *ul = new QVBoxLayout(usagePane);
+        ul->setContentsMargins(0,0,0,0);
+        usageTable = new QTableWidget(0, 12);
+        usageTable->setHorizontalHeaderLabels({"Finished", "Repository", "Operation", "Result", "Wall ms", "User ms", "Sys ms",
+                                               "Max RSS KB", "Read KB", "Written KB", "Disk read KB", "Disk written KB"});
+        usageTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        usageTable->setSortingEnabled(true);
+        usageTable->verticalHeader()->setVisible(false);
+        ul->addWidget(usageTable);
+        auto *usageBtns = new QHBoxLayout();
+        exportUsageBtn = new QPushButton("Export CSV...");
+        usageBtns->addStretch();
+        usageBtns->addWidget(exportUsageBtn);
+        ul->addLayout(usageBtns);
+        bottomTabs->addTab(usagePane, "Resources");
+        auto *dashPane = new QWidget();
+        auto *dl = new QVBoxLayout(dashPane);
+        dl->setContentsMargins(0,0,0,0);
+        auto *dashHeader = new QHBoxLayout();
+        dashLabel = new QLabel("Not checked yet");
+        dashRefreshBtn = new QPushButton("Refresh All");
+        dashRefreshBtn->setToolTip("Status of every repository in the clone directory; ahead/behind is as of each one's last fetch");
+        dashHeader->addWidget(dashLabel, 1);
+        dashHeader->addWidget(dashRefreshBtn);
+        dl->addLayout(dashHeader);
+        dashTable = new QTableWidget(0, DashColumns);
+        dashTable->setHorizontalHeaderLabels({"Repository", "State", "Branch", "Changes", "Untracked", "Conflicts",
+                                              "Ahead", "Behind", "Last fetch"});
+        dashTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        dashTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+        dashTable->setSortingEnabled(true);
+        dashTable->verticalHeader()->setVisible(false);
+        dl->addWidget(dashTable);
+        bottomTabs->addTab(dashPane, "Dashboard");
+        main->addWidget(bottomTabs);
+
+        localBaseDir = QDir::homePath() + "/qt-gh-clones";
+        appendLog("Default clone directory: " + localBaseDir);
+        loadWorkspaceDefaults();
+    }
+
+    void connectSignals()
+    {
+        connect(searchBtn, &QPushButton::clicked, this, &GitHubClient::onSearchRepos);
+        connect(cloneBtn, &QPushButton::clicked, this, &GitHubClient::onCloneSelected);
+        connect(snapshotBtn, &QPushButton::clicked, this, &GitHubClient::onSnapshotSelected);
+        connect(chooseDirBtn, &QPushButton::clicked, this, &GitHubClient::onChooseDir);
+        connect(repoList, &QListWidget::currentTextChanged, this, &GitHubClient::onRepoSelected);
+        connect(refreshLocalBtn, &QPushButton::clicked, this, &GitHubClient::onRefreshLocal);
+        connect(checkUpdatesBtn, &QPushButton::clicked, this, &GitHubClient::onCheckUpdates);
+        connect(pullBtn, &QPushButton::clicked, this, &GitHubClient::onPullSelected);
+        connect(diffBtn, &QPushButton::clicked, this, &GitHubClient::onShowDiff);
+        connect(pushBtn, &QPushButton::clicked, this, &GitHubClient::onPushIfChanged);
+        connect(jobs, &JobPool::changed, this, &GitHubClient::updateJobStatus);
+        connect(workersBox, QOverload<int>::of(&QSpinBox::valueChanged), jobs, &JobPool::setMaxConcurrent);
+        connect(jobs, &JobPool::jobStarted, this, &GitHubClient::onJobStarted);
+        connect(jobs, &JobPool::jobFinished, this, &GitHubClient::onJobFinished);
+        connect(jobList, &QListWidget::currentRowChanged, this, &GitHubClient::showJobOutput);
+        connect(exportUsageBtn, &QPushButton::clicked, this, &GitHubClient::exportUsage);
+        connect(dashRefreshBtn, &QPushButton::clicked, this, &GitHubClient::refreshDashboard);
+        connect(bottomTabs, &QTabWidget::currentChanged, this, [this](int i){
+            if(bottomTabs->widget(i)==dashTable->parentWidget() && dashTable->rowCount()==0) refreshDashboard();
+        });
+        connect(dashTable, &QTableWidget::cellDoubleClicked, this, [this](int row, int){
+            const QString name = dashTable->item(row, DashName)->text();
+            QList<QListWidgetItem*> found = repoList->findItems(name, Qt::MatchExactly);
+            if(found.isEmpty()){ repoList->addItem(name); found = repoList->findItems(name, Qt::MatchExactly); }
+            repoList->setCurrentItem(found.first());
+        });
+        jobs->setGroupLimit("clone", cloneLimitBox->value());
+        connect(cloneProfileBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int i){
+            cloneDepthBox->setEnabled(i==CloneProfile::Shallow);
+            saveWorkspaceDefaults();
+        });
+        connect(cloneDepthBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &GitHubClient::saveWorkspaceDefaults);
+        connect(objectCacheBox, &QCheckBox::toggled, this, &GitHubClient::saveWorkspaceDefaults);
+        connect(dissociateBox, &QCheckBox::toggled, this, &GitHubClient::saveWorkspaceDefaults);
+        connect(mirrorBox, &QCheckBox::toggled, this, &GitHubClient::saveWorkspaceDefaults);
+        connect(evictKeepBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &GitHubClient::saveWorkspaceDefaults);
+        connect(budgetBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](){
+            saveWorkspaceDefaults();
+            checkDiskBudget();
+        });
+        connect(worktreeBtn, &QPushButton::clicked, this, &GitHubClient::onAddWorktree);
+        connect(liveStatusBox, &QCheckBox::toggled, this, [this](){
+            saveWorkspaceDefaults();
+            updateWatchers();
+        });
+        connect(sparseBtn, &QPushButton::clicked, this, &GitHubClient::onSparseCheckout);
+        connect(largeRepoBtn, &QPushButton::clicked, this, &GitHubClient::onLargeRepoMode);
+        connect(bundleDirBtn, &QPushButton::clicked, this, [this](){
+            QString d = QFileDialog::getExistingDirectory(this, "Bundle Directory", bundleDir.isEmpty() ? localBaseDir : bundleDir);
+            if(d.isEmpty()){
+                if(bundleDir.isEmpty() || QMessageBox::question(this, "Bundles", "Stop using bundles from " + bundleDir + "?")!=QMessageBox::Yes) return;
+            }
+            setBundleDir(d);
+            saveWorkspaceDefaults();
+        });
+        connect(repoList, &QListWidget::customContextMenuRequested, this, [this](const QPoint &pos){
+            if(repoList->selectedItems().isEmpty()) return;
+            QMenu menu(this);
+            QMap<QAction*, CloneProfile> profiles;
+            for(const QString &n : CloneProfile::names()){
+                CloneProfile p = CloneProfile::fromName(n, cloneDepthBox->value());
+                profiles[menu.addAction("Clone as " + p.label())] = p;
+            }
+            menu.addSeparator();
+            QAction *autoAction = menu.addAction("Clone automatically...");
+            menu.addSeparator();
+            bool pinned = true;
+            for(QListWidgetItem *it : repoList->selectedItems()) pinned = pinned && pinnedRepos.contains(it->text());
+            QAction *pinAction = menu.addAction("Keep status live (pin)");
+            pinAction->setCheckable(true);
+            pinAction->setChecked(pinned);
+            QAction *chosen = menu.exec(repoList->mapToGlobal(pos));
+            if(profiles.contains(chosen)) cloneSelected(fixedClonePlan(profiles[chosen]), false);
+            else if(chosen && chosen==autoAction) cloneSelected([this](const QListWidgetItem *it){ return autoClonePlan(it); }, true);
+            else if(chosen && chosen==pinAction){
+                for(QListWidgetItem *it : repoList->selectedItems()){
+                    if(pinned) pinnedRepos.remove(it->text());
+                    else pinnedRepos.insert(it->text());
+                }
+                saveWorkspaceDefaults();
+                updateWatchers();
+            }
+        });
+        connect(cloneLimitBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int n){ jobs->setGroupLimit("clone", n); });
+        connect(diffPrevBtn, &QPushButton::clicked, this, [this](){
+            if(diffPageStarts.size()<2) return;
+            diffPageStarts.removeLast();
+            showDiffPage();
+        });
+        connect(diffNextBtn, &QPushButton::clicked, this, [this](){
+            if(!diffOutput || diffPageEnd>=diffOutput->size()) return;
+            diffPageStarts << diffPageEnd;
+            showDiffPage();
+        });
+        connect(cancelJobBtn, &QPushButton::clicked, this, [this](){
+            if(GitJob *job = jobs->findRunning(selectedJobId())) jobs->cancel(job);
+        });
+        connect(cancelAllBtn, &QPushButton::clicked, this, [this](){
+            appendLog("Cancelling all jobs...");
+            Retry::cancelAll();     // first, so attempts cancelled below are not retried
+            jobs->cancelAll();
+            snapshotQueue.clear();
+            for(SnapshotDownload *s : snapshots.values()) s->cancel();
+        });
+    }
+
+    // Shows the page starting at diffPageStarts.last(), cut back to a line boundary.
+    void showDiffPage()
+    {
+        const qint64 start = diffPageStarts.last();
+        QByteArray chunk = diffOutput->page(start, diffPageBytes);
+        if(start+chunk.size() < diffOutput->size()){
+            int nl = chunk.lastIndexOf('\n');
+            if(nl>0) chunk.truncate(nl+1);
+        }
+        diffPageEnd = start + chunk.size();
+        diffView->setPlainText(QString::fromUtf8(chunk));
+        const bool paged = diffOutput->size() > diffPageBytes;
+        diffPageLabel->setText(paged ? QString("%1-%2 of %3 KB").arg(start/1024).arg(diffPageEnd/1024).arg(diffOutput->size()/1024) : QString());
+        diffPrevBtn->setEnabled(diffPageStarts.size()>1);
+        diffNextBtn->setEnabled(diffPageEnd < diffOutput->size());
+    }
+
+    //=========================== JOB PANE ===================================
+    quint64 selectedJobId() const
+    {
+        QListWidgetItem *it = jobList->currentItem();
+        return it ? it->data(Qt::UserRole).toULongLong() : 0;
+    }
+
+    void onJobStarted(GitJob *job)
+    {
+        const quint64 id = job->id;
+        auto *it = new QListWidgetItem(QString("... #%1 %2").arg(id).arg(job->commandLine()));
+        it->setData(Qt::UserRole, id);
+        jobList->insertItem(0, it);
+        jobItems[id] = it;
+        jobLines[id] = QStringList();
+        while(jobList->count()>maxJobRecords){
+            QListWidgetItem *old = jobList->takeItem(jobList->count()-1);
+            quint64 oldId = old->data(Qt::UserRole).toULongLong();
+            jobItems.remove(oldId);
+            jobLines.remove(oldId);
+            delete old;
+        }
+        if(!job->stream) return;
+        connect(job, &GitJob::lines, this, [this, id](const QStringList &lines){
+            if(!jobLines.contains(id)) return;
+            QStringList &kept = jobLines[id];
+            kept += lines;
+            if(kept.size()>maxJobLines) kept = kept.mid(kept.size()-maxJobLines);
+            if(selectedJobId()==id) jobOutput->appendPlainText(lines.join('\n'));
+            appendLog(lines.join('\n'));
+        });
+        connect(job, &GitJob::progress, this, [this, id, job](const QString &line){
+            if(QListWidgetItem *it = jobItems.value(id))
+                it->setText(QString("... #%1 %2  [%3]").arg(id).arg(job->commandLine(), line.trimmed()));
+        });
+    }
+
+    void onJobFinished(GitJob *job, const JobResult &r)
+    {
+        const quint64 id = job->id;
+        if(r.usage.wallMs>=0) recordUsage(job, r);
+        QListWidgetItem *it = jobItems.value(id);
+        if(!it) return;
+        QString state = r.ok ? "ok" : r.cancelled ? "cancelled" : r.timedOut ? "timeout" : QString("exit %1").arg(r.exitCode);
+        it->setText(QString("[%1] #%2 %3").arg(state).arg(id).arg(job->commandLine()));
+        if(!job->stream && !r.err.isEmpty()){
+            jobLines[id] = r.err.split('\n');
+            if(selectedJobId()==id) showJobOutput();
+        }
+    }
+
+    void showJobOutput()
+    {
+        jobOutput->setPlainText(jobLines.value(selectedJobId()).join('\n'));
+    }
+
+    //=========================== RESOURCES ==================================
+    void recordUsage(GitJob *job, const JobResult &r)
+    {
+        const ResourceUsage &u = r.usage;
+        auto num = [](qint64 v){
+            auto *it = new QTableWidgetItem();
+            if(v>=0) it->setData(Qt::DisplayRole, v);
+            it->setTextAlignment(Qt::AlignRight|Qt::AlignVCenter);
+            return it;
+        };
+        auto kb = [](qint64 v){ return v>=0 ? v/1024 : v; };
+        auto *when = new QTableWidgetItem(QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
+        when->setData(Qt::UserRole, job->id);
+        auto *repo = new QTableWidgetItem(QFileInfo(job->repo).fileName());
+        repo->setToolTip(job->repo);
+        QString state = r.ok ? "ok" : r.cancelled ? "cancelled" : r.timedOut ? "timeout" : QString("exit %1").arg(r.exitCode);
+
+        usageTable->setSortingEnabled(false);
+        usageTable->insertRow(0);
+        QList<QTableWidgetItem*> cells{when, repo, new QTableWidgetItem(job->operation()), new QTableWidgetItem(state),
+                                       num(u.wallMs), num(u.userMs), num(u.sysMs), num(u.maxRssKb),
+                                       num(kb(u.readBytes)), num(kb(u.writeBytes)), num(kb(u.diskReadBytes)), num(kb(u.diskWriteBytes))};
+        for(int c=0; c<cells.size(); ++c) usageTable->setItem(0, c, cells[c]);
+        if(usageTable->rowCount()>maxUsageRows){
+            int oldest = 0;
+            for(int row=1; row<usageTable->rowCount(); ++row)
+                if(usageTable->item(row, 0)->data(Qt::UserRole).toULongLong() < usageTable->item(oldest, 0)->data(Qt::UserRole).toULongLong())
+                    oldest = row;
+            usageTable->removeRow(oldest);
+        }
+        usageTable->setSortingEnabled(true);
+    }
+
+    // Writes the table as shown (current sort order), repositories as full paths.
+    void exportUsage()
+    {
+        QString path = QFileDialog::getSaveFileName(this, "Export Resource Usage", localBaseDir + "/git-usage.csv", "CSV (*.csv)");
+        if(path.isEmpty()) return;
+        QSaveFile f(path);
+        if(!f.open(QIODevice::WriteOnly|QIODevice::Text)){
+            QMessageBox::warning(this, "Export", "Cannot write " + path);
+            return;
+        }
+        auto field = [](QString s){
+            if(s.contains(',') || s.contains('"') || s.contains('\n')) s = '"' + s.replace("\"", "\"\"") + '"';
+            return s;
+        };
+        QTextStream out(&f);
+        QStringList row;
+        for(int c=0; c<usageTable->columnCount(); ++c) row << field(usageTable->horizontalHeaderItem(c)->text());
+        out << row.join(',') << "\n";
+        for(int r=0; r<usageTable->rowCount(); ++r){
+            row.clear();
+            for(int c=0; c<usageTable->columnCount(); ++c){
+                QTableWidgetItem *it = usageTable->item(r, c);
+                row << field(!it ? QString() : c==1 ? it->toolTip() : it->text());
+            }
+            out << row.join(',') << "\n";
+        }
+        out.flush();
+        if(!f.commit()) QMessageBox::warning(this, "Export", "Cannot write " + path);
+        else appendLog(QString("Exported %1 command records to %2").arg(usageTable->rowCount()).arg(path));
+    }
+
+    //=========================== DASHBOARD ==================================
+    // Every clone under the clone directory at once: status runs for all of them on the
+    // job pool and rows fill in as results arrive. Cached statuses show meanwhile.
+    enum DashColumn { DashName, DashState, DashBranch, DashChanges, DashUntracked, DashConflicts,
+                      DashAhead, DashBehind, DashFetched, DashColumns };
+
+    void refreshDashboard()
+    {
+        const int gen = ++dashGeneration;
+        dashPending = 0;
+        dashRows.clear();
+        dashTable->setSortingEnabled(false);
+        dashTable->setRowCount(0);
+        QStringList names;
+        for(const QString &name : QDir(localBaseDir).entryList(QDir::Dirs|QDir::NoDotAndDotDot, QDir::Name))
+            if(QFileInfo::exists(QDir(localBaseDir).filePath(name + "/.git"))) names << name;
+        QSettings ws(workspaceFile(), QSettings::IniFormat);
+        ws.beginGroup("evicted");
+        const QStringList evicted = ws.childGroups();
+        ws.endGroup();
+        QStringList all = names;
+        for(const QString &name : evicted) if(!names.contains(name)) all << name;     // mid-restore ones are both
+        for(const QString &name : all){
+            const int row = dashTable->rowCount();
+            dashTable->insertRow(row);
+            auto *item = new QTableWidgetItem(name);
+            item->setToolTip(QDir(localBaseDir).filePath(name));
+            dashTable->setItem(row, DashName, item);
+            for(int c=DashState; c<DashColumns; ++c) dashTable->setItem(row, c, new QTableWidgetItem());
+            dashRows[name] = item;
+        }
+        for(const QString &name : all.mid(names.size())) dashTable->item(dashRows[name]->row(), DashState)->setText("evicted");
+        for(const QString &name : names){
+            const QString path = QDir(localBaseDir).filePath(name);
+            if(ResumableClone::isPartial(path)){ dashTable->item(dashRows[name]->row(), DashState)->setText("partial clone"); continue; }
+            // no validity check here: it stats every tracked directory, for hundreds of repositories
+            const StatusResult cached = statusCache->lookup(path);
+            if(cached.ok) fillDashRow(name, cached, true);
+            else dashTable->item(dashRows[name]->row(), DashState)->setText("checking");
+            ++dashPending;
+            // not through computeStatus: stamping cache keys for hundreds of repositories
+            // would stall the UI, and HEAD moves would queue an ls-tree each
+            backend()->status(path, [this, gen, name](const StatusResult &st){
+                if(gen!=dashGeneration) return;
+                --dashPending;
+                fillDashRow(name, st, false);
+                updateDashLabel();
+            }, JobPriority::Background);
+        }
+        dashTable->setSortingEnabled(true);
+        updateDashLabel();
+    }
+
+    void fillDashRow(const QString &name, const StatusResult &st, bool cached)
+    {
+        QTableWidgetItem *nameItem = dashRows.value(name);
+        if(!nameItem) return;
+        const int row = nameItem->row();
+        auto cell = [this, row](int column, const QVariant &value){
+            auto *it = new QTableWidgetItem();
+            it->setData(Qt::DisplayRole, value);
+            if(column>=DashChanges && column<=DashBehind) it->setTextAlignment(Qt::AlignRight|Qt::AlignVCenter);
+            dashTable->setItem(row, column, it);
+            return it;
+        };
+        const bool sorting = dashTable->isSortingEnabled();
+        dashTable->setSortingEnabled(false);        // keeps `row` in place while the row is filled
+        if(!st.ok){
+            cell(DashState, "error")->setToolTip(st.error);
+        } else {
+            int changes = 0, untracked = 0, conflicts = 0;
+            for(const StatusEntry &e : st.entries){
+                if(e.kind==StatusEntry::Untracked) ++untracked;
+                else if(e.kind==StatusEntry::Unmerged) ++conflicts;
+                else ++changes;
+            }
+            const BranchStatus &b = st.branch;
+            QStringList state;
+            if(conflicts) state << "conflicts";
+            if(changes) state << "uncommitted";
+            if(untracked) state << "untracked";
+            if(b.ahead) state << "unpushed";
+            if(b.behind) state << "behind";
+            if(b.upstream.isEmpty() && !b.head.isEmpty()) state << "no upstream";
+            if(state.isEmpty()) state << "clean";
+            if(cached) state << "(cached)";
+            cell(DashState, state.join(", "));
+            cell(DashBranch, b.head.isEmpty() ? "detached @ " + b.oid.left(7) : b.head)->setToolTip(branchText(b));
+            cell(DashChanges, changes);
+            cell(DashUntracked, untracked);
+            cell(DashConflicts, conflicts);
+            cell(DashAhead, b.upstream.isEmpty() ? QVariant() : QVariant(b.ahead));
+            cell(DashBehind, b.upstream.isEmpty() ? QVariant() : QVariant(b.behind));
+        }
+        const QDateTime fetched = lastFetchTime(QDir(localBaseDir).filePath(name));
+        cell(DashFetched, fetched.isValid() ? fetched.toString("yyyy-MM-dd HH:mm") : QString("never"));
+        dashTable->setSortingEnabled(sorting);
+    }
+
+    void updateDashLabel()
+    {
+        int dirty = 0, unpushed = 0, behind = 0;
+        for(int r=0; r<dashTable->rowCount(); ++r){
+            const QString s = dashTable->item(r, DashState)->text();
+            if(s.contains("uncommitted") || s.contains("untracked") || s.contains("conflicts")) ++dirty;
+            if(s.contains("unpushed")) ++unpushed;
+            if(s.contains("behind")) ++behind;
+        }
+        QString text = QString("%1 repositories: %2 with local changes, %3 unpushed, %4 behind")
+                       .arg(dashTable->rowCount()).arg(dirty).arg(unpushed).arg(behind);
+        if(dashPending) text += QString(" (%1 still checking)").arg(dashPending);
+        dashLabel->setText(text);
+    }
+
+    // A new clone directory: the table is filled again when it is looked at.
+    void resetDashboard()
+    {
+        ++dashGeneration;
+        dashPending = 0;
+        dashRows.clear();
+        dashTable->setRowCount(0);
+        dashLabel->setText("Not checked yet");
+        if(bottomTabs->currentWidget()==dashTable->parentWidget()) refreshDashboard();
+    }
 
-        auto *mid = new QWidget();
-        auto *ml = new QVBoxLayout(mid);
-        fileList = new QListWidget();
-        ml->addWidget(new QLabel("Files"));
-        ml->addWidget(fileList);
-        diffBtn = new QPushButton("Show Diff");
-        ml->addWidget(diffBtn);
-        split->addWidget(mid);
+    void updateJobStatus()
+    {
+        if(jobs->running()==0 && jobs->pending()==0) jobStatusLabel->setText("Jobs: idle");
+        else jobStatusLabel->setText(QString("Jobs: %1 running, %2 queued").arg(jobs->running()).arg(jobs->pending()));
+    }
 
-        auto *right = new QWidget();
-        auto *rl = new QVBoxLayout(right);
-        diffView = new QPlainTextEdit(); diffView->setReadOnly(true);
-        rl->addWidget(new QLabel("Diff"));
-        rl->addWidget(diffView);
-        pushBtn = new QPushButton("Commit & Push");
-        rl->addWidget(pushBtn);
-        split->addWidget(right);
+    GitJob *git(const QString &repo, const QStringList &args, int timeoutMs, GitJob::Callback done)
+    {
+        return jobs->submit("git", QStringList{"-C", repo} + args, timeoutMs, done);
+    }
 
-        main->addWidget(split);
+    // For long-running commands whose output belongs in the log as it arrives.
+    GitJob *gitStreamed(const QString &repo, const QStringList &args, int timeoutMs, GitJob::Callback done)
+    {
+        GitJob *job = git(repo, args, timeoutMs, done);
+        job->stream = true;
+        return job;
+    }
 
-        logView = new QPlainTextEdit(); logView->setReadOnly(true);
-        main->addWidget(new QLabel("Log"));
-        main->addWidget(logView);
+    GitBackend *backend() const { return backends.value(backendBox->currentIndex(), backends.first()); }
 
-        localBaseDir = QDir::homePath() + "/qt-gh-clones";
-        appendLog("Default clone directory: " + localBaseDir);
+    // Selected repositories that exist locally; falls back to the current item.
+    QStringList selectedLocalRepos() const
+    {
+        QList<QListWidgetItem*> sel = repoList->selectedItems();
+        if(sel.isEmpty() && repoList->currentItem()) sel << repoList->currentItem();
+        QStringList paths;
+        for(QListWidgetItem *it : sel){
+            QString p = QDir(localBaseDir).filePath(it->text());
+            if(QDir(p).exists()) paths << p;
+        }
+        return paths;
     }
 
-    void connectSignals()
+    QString currentRepoPath() const
     {
-        connect(searchBtn, &QPushButton::clicked, this, &GitHubClient::onSearchRepos);
-        connect(cloneBtn, &QPushButton::clicked, this, &GitHubClient::onCloneSelected);
-        connect(chooseDirBtn, &QPushButton::clicked, this, &GitHubClient::onChooseDir);
-        connect(repoList, &QListWidget::currentTextChanged, this, &GitHubClient::onRepoSelected);
-        connect(refreshLocalBtn, &QPushButton::clicked, this, &GitHubClient::onRefreshLocal);
-        connect(checkUpdatesBtn, &QPushButton::clicked, this, &GitHubClient::onCheckUpdates);
-        connect(pullBtn, &QPushButton::clicked, this, &GitHubClient::onPullSelected);
-        connect(diffBtn, &QPushButton::clicked, this, &GitHubClient::onShowDiff);
-        connect(pushBtn, &QPushButton::clicked, this, &GitHubClient::onPushIfChanged);
+        QListWidgetItem *it = repoList->currentItem();
+        return it ? QDir(localBaseDir).filePath(it->text()) : QString();
     }
 
     void appendLog(const QString &t)
@@ -175,12 +3218,16 @@ private slots:
         appendLog("Searching repos via GitHub REST API...");
 
         QUrl url(QString("https://api.github.com/users/%1/repos?per_page=100").arg(user));
+        QNetworkReply *r = net->get(apiRequest(url));
+        connect(r, &QNetworkReply::finished, this, [this, r](){ handleRepoListReply(r); });
+    }
+
+    QNetworkRequest apiRequest(const QUrl &url) const
+    {
         QNetworkRequest req(url);
         req.setHeader(QNetworkRequest::UserAgentHeader, "QtGitHubClient");
         if(!token.isEmpty()) req.setRawHeader("Authorization", "token " + token.toUtf8());
-
-        QNetworkReply *r = net->get(req);
-        connect(r, &QNetworkReply::finished, this, [this, r](){ handleRepoListReply(r); });
+        return req;
     }
 
     void handleRepoListReply(QNetworkReply *r)
@@ -205,7 +3252,19 @@ private slots:
             QString name = o.value("name").toString();
             QString ssh  = o.value("ssh_url").toString();
             QListWidgetItem *it = new QListWidgetItem(name);
-            it->setData(Qt::UserRole, ssh);
+            it->setData(SshUrlRole, ssh);
+            it->setData(FullNameRole, o.value("full_name").toString());
+            it->setData(SizeKbRole, qint64(o.value("size").toDouble()));
+            it->setData(ForkRole, o.value("fork").toBool());
+            it->setData(ArchivedRole, o.value("archived").toBool());
+            it->setData(DefaultBranchRole, o.value("default_branch").toString());
+            it->setData(PushedAtRole, QDateTime::fromString(o.value("pushed_at").toString(), Qt::ISODate));
+            QStringList tip{o.value("full_name").toString(), formatSize(qint64(o.value("size").toDouble())*1024),
+                            "default branch " + o.value("default_branch").toString(),
+                            "pushed " + o.value("pushed_at").toString().left(10)};
+            if(o.value("fork").toBool()) tip << "fork";
+            if(o.value("archived").toBool()) tip << "archived";
+            it->setToolTip(tip.join(", "));
             repoList->addItem(it);
         }
         appendLog(QString("Loaded %1 repos.").arg(repoList->count()));
@@ -215,67 +3274,947 @@ private slots:
     void onChooseDir()
     {
         QString d = QFileDialog::getExistingDirectory(this,"Choose Clone Directory",localBaseDir);
-        if(!d.isEmpty()){ localBaseDir = d; appendLog("Clone dir set: "+d); }
+        if(!d.isEmpty()){ localBaseDir = d; appendLog("Clone dir set: "+d); loadWorkspaceDefaults(); }
     }
 
     void onCloneSelected()
+    {
+        if(cloneProfileBox->currentText()=="auto") cloneSelected([this](const QListWidgetItem *it){ return autoClonePlan(it); }, true);
+        else cloneSelected(fixedClonePlan(defaultCloneProfile()), false);
+    }
+
+    // `confirm` lists every repository with its plan and asks before anything starts.
+    void cloneSelected(std::function<ClonePlan(const QListWidgetItem *)> planFor, bool confirm)
     {
         auto sel = repoList->selectedItems();
         if(sel.isEmpty()){ QMessageBox::information(this,"Select","Select a repo"); return; }
+        struct Pending { QString name, ssh, target; ClonePlan plan; };
+        QList<Pending> todo;
         for(QListWidgetItem *it : sel){
             QString name = it->text();
-            QString ssh  = it->data(Qt::UserRole).toString();
+            QString ssh  = it->data(SshUrlRole).toString();
             if(ssh.isEmpty()){ appendLog("No SSH URL for "+name); continue; }
             QString target = QDir(localBaseDir).filePath(name);
-            if(QDir(target).exists()){ appendLog("Already exists: "+target); continue; }
-            appendLog("Cloning "+ssh);
-            QString out, err;
-            bool ok = runCommand("git", {"clone", ssh, target}, out, err, 0);
-            appendLog(out + "y" + err);
-            if(!ok) QMessageBox::warning(this,"Clone failed",err);
+            if(isEvicted(name)){ restoreRepo(name); continue; }
+            if(QDir(target).exists() && !ResumableClone::isPartial(target)){ appendLog("Already exists: "+target); continue; }
+            if(clones.contains(target) && !clones[target].done) continue;
+            ClonePlan plan = planFor(it);
+            plan.branch = it->data(DefaultBranchRole).toString();
+            todo << Pending{name, ssh, target, plan};
+        }
+        if(confirm && !todo.isEmpty()){
+            QStringList lines;
+            for(const Pending &p : todo.mid(0, 30))
+                lines << QString("%1: %2%3 (%4)").arg(p.name, p.plan.profile.label(),
+                                                    p.plan.objectCache && p.plan.profile.usesObjectCache() ? QString(" + object cache") : QString(), p.plan.reason);
+            if(todo.size()>30) lines << QString("... and %1 more").arg(todo.size()-30);
+            if(QMessageBox::question(this, "Clone", QString("Clone %1 repositories like this?\n\n").arg(todo.size()) + lines.join('\n'),
+                                     QMessageBox::Ok|QMessageBox::Cancel)!=QMessageBox::Ok) return;
+        }
+        bool idle = true;
+        for(const CloneState &c : clones) if(!c.done) idle = false;
+        if(idle){   // start a new batch
+            clones.clear();
+            clonesFailed = 0;
+            cloneTable->setRowCount(0);
+            cloneTimer.start();
+        }
+        for(const Pending &p : todo) startClone(p.name, p.ssh, p.target, p.plan);
+        if(todo.isEmpty() && idle) onRefreshLocal();
+        else bottomTabs->setCurrentWidget(cloneTable->parentWidget());
+        updateCloneTotals();
+    }
+
+    std::function<ClonePlan(const QListWidgetItem *)> fixedClonePlan(const CloneProfile &profile)
+    {
+        const bool cache = objectCacheBox->isChecked();
+        return [profile, cache](const QListWidgetItem *){
+            ClonePlan plan;
+            plan.profile = profile;
+            plan.objectCache = cache;
+            return plan;
+        };
+    }
+
+    // "auto": archived repositories only need their default branch, large ones get
+    // file contents on demand, and forks share objects with their relatives.
+    ClonePlan autoClonePlan(const QListWidgetItem *it) const
+    {
+        ClonePlan plan;
+        plan.objectCache = objectCacheBox->isChecked();
+        const qint64 kb = it->data(SizeKbRole).toLongLong();
+        if(it->data(ArchivedRole).toBool()){
+            plan.profile.kind = CloneProfile::SingleBranch;
+            plan.reason = "archived";
+        } else if(kb>bloblessAboveKb){
+            plan.profile.kind = CloneProfile::Blobless;
+            plan.reason = formatSize(kb*1024) + " on GitHub";
+        } else if(it->data(ForkRole).toBool()){
+            plan.objectCache = true;
+            plan.reason = "fork, " + formatSize(kb*1024);
+        } else plan.reason = formatSize(kb*1024);
+        return plan;
+    }
+
+    static QString formatSize(qint64 bytes)
+    {
+        if(bytes>=1024LL*1024*1024) return QString::number(bytes/(1024.0*1024*1024), 'f', 1) + " GB";
+        if(bytes>=1024*1024) return QString::number(bytes/(1024*1024)) + " MB";
+        return QString::number(bytes/1024) + " KB";
+    }
+
+    // Snapshots share the Clones tab, its batch summary and its parallel limit.
+    void onSnapshotSelected()
+    {
+        auto sel = repoList->selectedItems();
+        if(sel.isEmpty()){ QMessageBox::information(this,"Select","Select a repo"); return; }
+        bool idle = snapshots.isEmpty() && snapshotQueue.isEmpty();
+        for(const CloneState &c : clones) if(!c.done) idle = false;
+        if(idle){
+            clones.clear();
+            clonesFailed = 0;
+            cloneTable->setRowCount(0);
+            cloneTimer.start();
+        }
+        int added = 0;
+        for(QListWidgetItem *it : sel){
+            const QString name = it->text();
+            const QString target = QDir(localBaseDir).filePath(name);
+            if(QDir(target).exists() || clones.contains(target)){ appendLog("Already exists: "+target); continue; }
+            QString fullName = it->data(FullNameRole).toString();
+            if(fullName.isEmpty()) fullName = usernameEdit->text().trimmed() + "/" + name;
+            const QString ref = it->data(DefaultBranchRole).toString();
+            addCloneRow(name, "snapshot of " + (ref.isEmpty() ? QString("default branch") : ref), target);
+            snapshotQueue << [this, name, fullName, ref, target](){ startSnapshot(name, fullName, ref, target); };
+            ++added;
+        }
+        if(!added) return;
+        bottomTabs->setCurrentWidget(cloneTable->parentWidget());
+        updateCloneTotals();
+        nextSnapshots();
+    }
+
+    void nextSnapshots()
+    {
+        while(!snapshotQueue.isEmpty() && snapshots.size()<cloneLimitBox->value()) snapshotQueue.takeFirst()();
+    }
+
+    void startSnapshot(const QString &name, const QString &fullName, const QString &ref, const QString &target)
+    {
+        QUrl url("https://api.github.com/repos/" + fullName + "/tarball" + (ref.isEmpty() ? QString() : "/" + ref));
+        appendLog("Snapshot "+url.toString());
+        auto *s = new SnapshotDownload(net, apiRequest(url), target, this);
+        snapshots.insert(s);
+        clones[target].startedAt = QDateTime::currentMSecsSinceEpoch();
+        setCloneProgress(target, "starting", 0);
+        connect(s, &SnapshotDownload::progress, this, [this, target](qint64 got, qint64 total){
+            // codeload streams without a length most of the time
+            setCloneProgress(target, "downloading " + formatSize(got), total>0 ? 0.99*got/total : 0);
+        });
+        connect(s, &SnapshotDownload::finished, this, [this, s, name, target](const JobResult &r){
+            snapshots.remove(s);
+            finishClone(name, target, r);
+            nextSnapshots();
+        });
+        s->start();
+    }
+
+    //=========================== CLONES =====================================
+    void startClone(const QString &name, const QString &ssh, const QString &target, const ClonePlan &plan)
+    {
+        const CloneProfile &profile = plan.profile;
+        appendLog("Cloning "+ssh+" ("+profile.label()+")");
+        addCloneRow(name, profile.label(), target);
+
+        const bool cached = plan.objectCache && profile.usesObjectCache();
+        const bool dissociate = dissociateBox->isChecked();
+        const QString cache = objectCacheDir();
+        // Bundles hold full history; shallow and partial clones stay on the network path.
+        const bool mirror = mirrorBox->isChecked();
+        const QString bundle = profile.usesObjectCache() && !mirror ? bundleFor(name) : QString();
+        // First try a plain clone; after a network failure, or for a partial clone
+        // left behind earlier, continue resumably. Bundle clones retry from wherever
+        // the last attempt got to.
+        auto attempt = [this, name, ssh, target, profile, plan, cached, dissociate, cache, bundle, mirror](int n, GitJob::Callback done){
+            if(mirror){
+                cloneViaMirror(name, ssh, target, plan, done);
+                return;
+            }
+            if(!bundle.isEmpty() && (!ResumableClone::isPartial(target) || isBundleSeed(target))){
+                cloneFromBundle(bundle, ssh, target, plan, done);
+                return;
+            }
+            if(n>1 || ResumableClone::isPartial(target)){
+                ResumableClone::run(jobs, ssh, target, plan, cached ? cache : QString(), dissociate, [this, target](GitJob *job){
+                    trackCloneJob(job, target, 0.0, 0.95, "resume: ");
+                }, done);
+                return;
+            }
+            QStringList args = QStringList{"clone", "--progress"} + profile.cloneArgs();
+            if(cached){
+                args << "--reference-if-able" << cache;
+                if(dissociate) args << "--dissociate";
+            }
+            args << ssh << target;
+            GitJob *job = jobs->submit("git", args, 0, done, target);
+            job->cleanupDir = target;
+            trackCloneJob(job, target, cached ? 0.85 : 0.0, 1.0, QString());
+        };
+        auto retrying = [this, name, target](int retry, int delayMs, const JobResult &r){
+            appendLog(QString("%1: %2 failure, retry %3 in %4s: %5").arg(name, failureName(classifyFailure(r))).arg(retry)
+                      .arg(delayMs/1000).arg(r.err.trimmed().section('\n', -1)));
+            cloneTable->item(clones[target].row, 1)->setText(QString("retry %1 in %2s").arg(retry).arg(delayMs/1000));
+        };
+        auto clone = [this, name, target, attempt, retrying](){
+            Retry::run(this, RetryPolicy(), attempt, [this, name, target](const JobResult &r){ finishClone(name, target, r); }, retrying);
+        };
+        if(!bundle.isEmpty()) appendLog("Seeding "+name+" from "+bundle);
+        if(!cached || mirror || !bundle.isEmpty() || ResumableClone::isPartial(target)){ clone(); return; }
+        Retry::run(this, RetryPolicy(), [this, name, ssh, target](int, GitJob::Callback done){ fetchIntoCache(name, ssh, target, done); },
+                   [this, name, target, clone](const JobResult &r){
+            if(r.cancelled){ finishClone(name, target, r); return; }
+            if(!r.ok) appendLog("Object cache fetch failed for "+name+", cloning without it: "+r.err.trimmed());
+            clone();
+        }, retrying);
+    }
+
+    QString bundleFor(const QString &name) const
+    {
+        if(bundleDir.isEmpty()) return QString();
+        QString f = QDir(bundleDir).filePath(name + ".bundle");
+        return QFileInfo::exists(f) ? f : QString();
+    }
+
+    // Clone from the local bundle, point origin at GitHub, fetch what is newer than
+    // the bundle and move the default branch to it. A target already seeded by an
+    // earlier attempt goes straight to the fetch.
+    // A clone seeded from a bundle whose delta fetch has not succeeded yet: it carries the
+    // partial marker (so Clone resumes it) with "bundle" in it (so it resumes here).
+    static bool isBundleSeed(const QString &target)
+    {
+        QFile marker(QDir(target).filePath(".git/gitmanager-partial"));
+        return marker.open(QIODevice::ReadOnly) && marker.readAll().trimmed()=="bundle";
+    }
+
+    void cloneFromBundle(const QString &bundle, const QString &url, const QString &target, const ClonePlan &plan, GitJob::Callback finished)
+    {
+        const QString markerPath = QDir(target).filePath(".git/gitmanager-partial");
+        GitJob::Callback done = [markerPath, finished](const JobResult &r){
+            if(r.ok) QFile::remove(markerPath);
+            finished(r);
+        };
+        auto fetchDelta = [this, url, target, plan, done](){
+            git(target, {"remote", "set-url", "origin", url}, 10000, [this, target, plan, done](const JobResult &r){
+                if(!r.ok){ done(r); return; }
+                GitJob *job = git(target, {"fetch", "--progress", "origin"}, 0, [this, target, plan, done](const JobResult &r){
+                    if(!r.ok){ done(r); return; }
+                    git(target, plan.branch.isEmpty() ? QStringList{"merge", "--ff-only", "@{u}"}
+                                                      : QStringList{"checkout", "-B", plan.branch, "--track", "origin/" + plan.branch},
+                        60000, done);
+                });
+                trackCloneJob(job, target, 0.6, 1.0, "delta: ");
+            });
+        };
+        if(QFileInfo::exists(QDir(target).filePath(".git/HEAD"))){ fetchDelta(); return; }
+        GitJob *job = jobs->submit("git", QStringList{"clone", "--progress"} + plan.profile.cloneArgs() + QStringList{bundle, target}, 0,
+                                   [fetchDelta, done, markerPath](const JobResult &r){
+            if(!r.ok){ done(r); return; }
+            QFile marker(markerPath);      // clone wants an empty directory, so the marker comes right after
+            if(marker.open(QIODevice::WriteOnly)) marker.write("bundle\n");
+            marker.close();
+            fetchDelta();
+        }, target);
+        job->cleanupDir = target;
+        trackCloneJob(job, target, 0.0, 0.6, "bundle: ");
+    }
+
+    QString mirrorDir(const QString &name) const { return QDir(localBaseDir).filePath(".git-manager/mirrors/" + name + ".git"); }
+
+    // Mirror mode: a bare repository per GitHub repository, with working directories
+    // as its worktrees. Remote branches are fetched into refs/remotes/origin/* rather
+    // than mirrored onto refs/heads/*, so a fetch never moves a branch that some
+    // worktree has checked out. An existing mirror is just refreshed.
+    void cloneViaMirror(const QString &name, const QString &url, const QString &target, const ClonePlan &plan, GitJob::Callback done)
+    {
+        const QString mirror = mirrorDir(name);
+        auto addWorktree = [this, mirror, target, done](const QString &branch){
+            QStringList args{"-C", mirror, "worktree", "add"};
+            if(!branch.isEmpty()) args << "-B" << branch << target << "origin/" + branch;
+            else args << target;
+            jobs->submit("git", args, 60000, done, mirror)->cleanupDir = target;
+        };
+        auto checkout = [this, mirror, plan, addWorktree, done](const JobResult &r){
+            if(!r.ok){ done(r); return; }
+            // forget worktrees whose directories were deleted, so the path can be reused
+            jobs->submit("git", {"-C", mirror, "worktree", "prune"}, 10000, [this, mirror, plan, addWorktree, done](const JobResult &pr){
+                if(!pr.ok){ done(pr); return; }
+                if(!plan.branch.isEmpty()){ addWorktree(plan.branch); return; }
+                jobs->submit("git", {"-C", mirror, "symbolic-ref", "--short", "HEAD"}, 10000, [addWorktree, done](const JobResult &r){
+                    if(r.cancelled){ done(r); return; }
+                    addWorktree(r.ok ? r.out.trimmed() : QString());    // detached: a worktree at the mirror's HEAD
+                }, mirror);
+            }, mirror);
+        };
+        auto fetch = [this, mirror, target, plan, checkout](){
+            GitJob *job = jobs->submit("git", QStringList{"-C", mirror, "fetch", "--progress", "--prune", "origin"} + plan.profile.fetchArgs(),
+                                       0, checkout, mirror);
+            trackCloneJob(job, target, 0.8, 0.95, "mirror: ");
+        };
+        if(QFileInfo::exists(QDir(mirror).filePath("HEAD"))){ fetch(); return; }
+
+        QString refspec = "+refs/heads/*:refs/remotes/origin/*";
+        if(plan.profile.kind==CloneProfile::SingleBranch && !plan.branch.isEmpty())
+            refspec = QString("+refs/heads/%1:refs/remotes/origin/%1").arg(plan.branch);
+        GitJob *job = jobs->submit("git", QStringList{"clone", "--bare", "--progress"} + plan.profile.cloneArgs() + QStringList{url, mirror}, 0,
+                                   [this, mirror, refspec, fetch, done](const JobResult &r){
+            if(!r.ok){ done(r); return; }
+            jobs->submit("git", {"-C", mirror, "config", "remote.origin.fetch", refspec}, 10000, [fetch, done](const JobResult &r){
+                if(r.ok) fetch(); else done(r);
+            }, mirror);
+        }, mirror);
+        job->cleanupDir = mirror;
+        trackCloneJob(job, target, 0.0, 0.8, "mirror: ");
+    }
+
+    void addCloneRow(const QString &name, const QString &tooltip, const QString &target)
+    {
+        const int row = cloneTable->rowCount();
+        cloneTable->insertRow(row);
+        auto *nameItem = new QTableWidgetItem(name);
+        nameItem->setToolTip(tooltip);
+        cloneTable->setItem(row, 0, nameItem);
+        cloneTable->setItem(row, 1, new QTableWidgetItem("queued"));
+        auto *bar = new QProgressBar();
+        bar->setRange(0, 1000);
+        bar->setTextVisible(false);
+        cloneTable->setCellWidget(row, 2, bar);
+        cloneTable->setItem(row, 3, new QTableWidgetItem());
+        CloneState &st = clones[target];
+        st = CloneState();
+        st.row = row;
+    }
+
+    void finishClone(const QString &name, const QString &target, const JobResult &r)
+    {
+        CloneState &st = clones[target];
+        st.done = true;
+        st.failure = r.ok ? QString() : failureName(classifyFailure(r));
+        if(r.ok){
+            setCloneProgress(target, "done", 1.0);
+            touchRepo(target);
+        } else {
+            ++clonesFailed;
+            cloneTable->item(st.row, 1)->setText(st.failure);
+            cloneTable->item(st.row, 3)->setToolTip(r.err);
+            appendLog(QString("Clone %1 (%2): %3").arg(name, st.failure, r.cancelled ? QString() : r.err.trimmed()));
+            if(ResumableClone::isPartial(target)) appendLog("Partial clone kept in "+target+"; clone it again to resume.");
+        }
+        cloneTable->item(st.row, 3)->setText(r.ok ? QString("done in %1").arg(formatDuration(QDateTime::currentMSecsSinceEpoch() - st.startedAt)) : st.failure);
+        updateCloneTotals();
+        bool idle = true;
+        for(const CloneState &c : clones) if(!c.done) idle = false;
+        if(idle) checkDiskBudget();
+        QMap<QString, int> kinds;
+        for(const CloneState &c : clones){
+            if(!c.done) return;
+            if(!c.failure.isEmpty()) ++kinds[c.failure];
+        }
+        appendLog(QString("Cloned %1 of %2 repositories in %3").arg(clones.size()-clonesFailed).arg(clones.size()).arg(formatDuration(cloneTimer.elapsed())));
+        if(clonesFailed){
+            QStringList byKind;
+            for(auto it = kinds.constBegin(); it!=kinds.constEnd(); ++it) byKind << QString("%1: %2").arg(it.key()).arg(it.value());
+            QMessageBox::warning(this, "Clone", QString("%1 of %2 clones failed (%3); see the Clones tab.").arg(clonesFailed).arg(clones.size()).arg(byKind.join(", ")));
         }
         onRefreshLocal();
     }
 
-    void onRepoSelected(){ onRefreshLocal(); }
+    // Feeds a job's --progress output into the clone's row, scaled to [from, to].
+    void trackCloneJob(GitJob *job, const QString &target, double from, double to, const QString &phasePrefix)
+    {
+        job->stream = true;
+        job->group = "clone";
+        connect(job, &GitJob::started, this, [this, target](){
+            CloneState &st = clones[target];
+            if(st.startedAt) return;
+            st.startedAt = QDateTime::currentMSecsSinceEpoch();
+            setCloneProgress(target, "starting", 0);
+        });
+        auto parse = [this, target, from, to, phasePrefix](const QString &line){
+            QString phase;
+            double f;
+            if(parseCloneProgress(line, phase, f)) setCloneProgress(target, phasePrefix + phase, from + (to - from) * f);
+        };
+        connect(job, &GitJob::progress, this, parse);
+        connect(job, &GitJob::lines, this, [parse](const QStringList &lines){ for(const QString &l : lines) parse(l); });
+    }
+
+    QString objectCacheDir() const { return QDir(localBaseDir).filePath(".git-manager/objects.git"); }
+
+    // One bare repository holds the objects of every cached clone. Each repository's
+    // refs live under refs/cache/<name>/, so they never collide and nothing a clone
+    // borrows becomes unreachable; fetches negotiate against all of them, so history
+    // shared with a fork already in the cache is not downloaded again. Fetches for
+    // different repositories run in parallel (git writes packs atomically).
+    void fetchIntoCache(const QString &name, const QString &url, const QString &target, GitJob::Callback done)
+    {
+        const QString cache = objectCacheDir();
+        auto fetch = [this, name, url, target, cache, done](){
+            const QString ns = "refs/cache/" + name;
+            GitJob *job = jobs->submit("git", {"-C", cache, "fetch", "--progress", "--no-tags", url,
+                                               "+refs/heads/*:" + ns + "/heads/*", "+refs/tags/*:" + ns + "/tags/*"},
+                                       0, done, cache + "#" + name);
+            trackCloneJob(job, target, 0.0, 0.85, "cache: ");
+        };
+        if(QDir(cache).exists()){ fetch(); return; }
+        // Keyed on the cache itself, so simultaneous first clones initialise it one after another.
+        jobs->submit("git", {"init", "--bare", cache}, 30000, [this, cache, fetch, done](const JobResult &r){
+            if(!r.ok){ done(r); return; }
+            // Clones see these objects through alternates; the cache must never prune them.
+            git(cache, {"config", "gc.pruneExpire", "never"}, 10000, [fetch, done](const JobResult &c){
+                if(!c.ok){ done(c); return; }   // cancelled, or a cache that could prune borrowed objects
+                fetch();
+            });
+        }, cache);
+    }
+
+    // Maps a `git clone --progress` line onto the whole clone: receiving dominates,
+    // then delta resolution, then checkout.
+    static bool parseCloneProgress(const QString &line, QString &phase, double &fraction)
+    {
+        static const struct { const char *name; double from, to; } phases[] = {
+            {"Enumerating objects", 0.0, 0.02}, {"Counting objects", 0.0, 0.02}, {"Compressing objects", 0.02, 0.05},
+            {"Receiving objects", 0.05, 0.75}, {"Resolving deltas", 0.75, 0.95},
+            {"Updating files", 0.95, 1.0}, {"Checking out files", 0.95, 1.0},
+        };
+        QRegExp rx("^(?:remote: )?([A-Za-z ]+):\\s+(\\d+)%");
+        if(rx.indexIn(line.trimmed())<0) return false;
+        for(const auto &p : phases){
+            if(rx.cap(1)!=p.name) continue;
+            phase = p.name;
+            fraction = p.from + (p.to - p.from) * rx.cap(2).toInt() / 100.0;
+            return true;
+        }
+        return false;
+    }
+
+    void setCloneProgress(const QString &target, const QString &phase, double fraction)
+    {
+        CloneState &st = clones[target];
+        if(fraction<st.fraction && phase!="starting") fraction = st.fraction;   // phases overlap a little
+        st.fraction = fraction;
+        cloneTable->item(st.row, 1)->setText(phase);
+        if(auto *bar = qobject_cast<QProgressBar*>(cloneTable->cellWidget(st.row, 2))) bar->setValue(int(fraction*1000));
+        if(!st.done && st.startedAt && fraction>0.02)
+            cloneTable->item(st.row, 3)->setText(formatDuration(qint64((QDateTime::currentMSecsSinceEpoch() - st.startedAt) * (1-fraction) / fraction)));
+        updateCloneTotals();
+    }
+
+    // Overall progress counts every repository of the batch equally.
+    void updateCloneTotals()
+    {
+        if(clones.isEmpty()){ cloneTotalBar->setValue(0); cloneTotalLabel->setText("No clones"); return; }
+        double sum = 0;
+        int done = 0;
+        for(const CloneState &c : clones){
+            sum += c.done ? 1.0 : c.fraction;
+            if(c.done) ++done;
+        }
+        const double f = sum / clones.size();
+        cloneTotalBar->setValue(int(f*1000));
+        QString text = QString("%1/%2 finished").arg(done).arg(clones.size());
+        if(clonesFailed) text += QString(", %1 failed").arg(clonesFailed);
+        if(done<clones.size() && f>0.01) text += ", ETA " + formatDuration(qint64(cloneTimer.elapsed() * (1-f) / f));
+        cloneTotalLabel->setText(text);
+    }
+
+    // Per clone directory, in <localBaseDir>/.git-manager/workspace.ini.
+    QString workspaceFile() const { return QDir(localBaseDir).filePath(".git-manager/workspace.ini"); }
+
+    void loadWorkspaceDefaults()
+    {
+        QSettings ws(workspaceFile(), QSettings::IniFormat);
+        QSignalBlocker b1(cloneProfileBox), b2(cloneDepthBox), b3(objectCacheBox), b4(dissociateBox), b5(mirrorBox),
+                       b6(budgetBox), b7(evictKeepBox), b8(liveStatusBox);
+        cloneProfileBox->setCurrentIndex(qMax(0, cloneProfileBox->findText(ws.value("clone/profile", "full").toString())));
+        cloneDepthBox->setValue(qMax(1, ws.value("clone/depth", 1).toInt()));
+        cloneDepthBox->setEnabled(cloneProfileBox->currentIndex()==CloneProfile::Shallow);
+        objectCacheBox->setChecked(ws.value("cache/enabled", false).toBool());
+        dissociateBox->setChecked(ws.value("cache/dissociate", false).toBool());
+        setBundleDir(ws.value("bundles/dir").toString());
+        mirrorBox->setChecked(ws.value("mirror/enabled", false).toBool());
+        budgetBox->setValue(ws.value("budget/gb", 0).toInt());
+        evictKeepBox->setCurrentIndex(qMax(0, evictKeepBox->findText(ws.value("budget/keep", "bundle").toString())));
+        statusCache->load(localBaseDir);
+        liveStatusBox->setChecked(ws.value("status/live", true).toBool());
+        pinnedRepos.clear();
+        for(const QString &name : ws.value("status/pinned").toStringList()) pinnedRepos.insert(name);
+        QTimer::singleShot(0, this, &GitHubClient::checkDiskBudget);
+        QTimer::singleShot(0, this, &GitHubClient::updateWatchers);
+        QTimer::singleShot(0, this, &GitHubClient::resetDashboard);
+    }
+
+    void saveWorkspaceDefaults()
+    {
+        QDir().mkpath(QFileInfo(workspaceFile()).absolutePath());
+        QSettings ws(workspaceFile(), QSettings::IniFormat);
+        ws.setValue("clone/profile", cloneProfileBox->currentText());
+        ws.setValue("clone/depth", cloneDepthBox->value());
+        ws.setValue("cache/enabled", objectCacheBox->isChecked());
+        ws.setValue("cache/dissociate", dissociateBox->isChecked());
+        ws.setValue("bundles/dir", bundleDir);
+        ws.setValue("mirror/enabled", mirrorBox->isChecked());
+        ws.setValue("budget/gb", budgetBox->value());
+        ws.setValue("budget/keep", evictKeepBox->currentText());
+        ws.setValue("status/live", liveStatusBox->isChecked());
+        ws.setValue("status/pinned", QStringList(pinnedRepos.values()));
+    }
+
+    void setBundleDir(const QString &d)
+    {
+        bundleDir = d;
+        bundleDirBtn->setText("Bundles: " + (d.isEmpty() ? QString("none") : QFileInfo(d).fileName()));
+        if(!d.isEmpty()) appendLog("Bundle directory: " + d);
+    }
+
+    CloneProfile defaultCloneProfile() const
+    {
+        return CloneProfile::fromName(cloneProfileBox->currentText(), cloneDepthBox->value());
+    }
+
+    // Profile recorded in the repository at clone time (full if none).
+    void readCloneProfile(const QString &repo, std::function<void(const CloneProfile &)> cb)
+    {
+        git(repo, {"config", "--get-regexp", "^gitmanager\\."}, 10000, [cb](const JobResult &r){
+            cb(CloneProfile::fromConfig(r.ok ? r.out : QString()));
+        })->readOnly = true;
+    }
+
+    //=========================== DISK BUDGET ================================
+    // Everything under localBaseDir counts against the budget. Over budget, the least
+    // recently used clean clones are evicted: the checkout is deleted and a bundle of
+    // all refs, or the .git directory itself, stays in .git-manager/evicted. Selecting
+    // or cloning an evicted repository restores it.
+    QString evictedDir() const { return QDir(localBaseDir).filePath(".git-manager/evicted"); }
+
+    void touchRepo(const QString &path)
+    {
+        QDir().mkpath(QFileInfo(workspaceFile()).absolutePath());
+        QSettings ws(workspaceFile(), QSettings::IniFormat);
+        ws.setValue("lastUse/" + QFileInfo(path).fileName(), QDateTime::currentMSecsSinceEpoch());
+    }
+
+    bool isEvicted(const QString &name) const
+    {
+        QSettings ws(workspaceFile(), QSettings::IniFormat);
+        return ws.contains("evicted/" + name + "/kind");
+    }
+
+    void checkDiskBudget()
+    {
+        if(budgetRunning){ budgetRecheck = true; return; }
+        if(!budgetBox->value()){ updateDiskLabel(-1); return; }    // off: no du over the whole clone directory
+        QStringList paths;
+        for(const QFileInfo &fi : QDir(localBaseDir).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden)) paths << fi.filePath();
+        if(paths.isEmpty()){ diskLabel->setText("Disk: empty"); return; }
+        budgetRunning = true;
+        jobs->submit("du", QStringList{"-sk", "--"} + paths, 300000, [this](const JobResult &r){
+            // du still lists what it could read when it fails on some entries
+            QMap<QString, qint64> sizes;
+            qint64 total = 0;
+            for(const QString &l : r.out.split('\n', QString::SkipEmptyParts)){
+                const qint64 kb = l.section('\t', 0, 0).toLongLong();
+                sizes[QFileInfo(l.section('\t', 1)).fileName()] = kb;
+                total += kb;
+            }
+            const qint64 budget = qint64(budgetBox->value())*1024*1024;
+            if(!budget || total<=budget){ finishDiskBudget(total); return; }
+            appendLog(QString("Disk budget: %1 used, %2 over").arg(formatSize(total*1024), formatSize((total-budget)*1024)));
+            evictUntil(evictionCandidates(sizes), total - budget, total);
+        });
+    }
+
+    void finishDiskBudget(qint64 totalKb)
+    {
+        budgetRunning = false;
+        updateDiskLabel(totalKb);
+        if(budgetRecheck){
+            budgetRecheck = false;
+            checkDiskBudget();
+        }
+    }
+
+    // totalKb is -1 when usage was not measured (budget off).
+    void updateDiskLabel(qint64 totalKb)
+    {
+        QSettings ws(workspaceFile(), QSettings::IniFormat);
+        ws.beginGroup("evicted");
+        const int evicted = ws.childGroups().size();
+        ws.endGroup();
+        QString text = totalKb<0 ? QString("Disk: not measured") : "Disk: " + formatSize(totalKb*1024);
+        if(budgetBox->value()) text += QString(" of %1 GB").arg(budgetBox->value());
+        if(evicted) text += QString(", %1 evicted").arg(evicted);
+        const int restores = ws.value("budget/restores", 0).toInt();
+        if(restores) text += QString(", restore avg %1 ms over %2").arg(ws.value("budget/restoreMs", 0).toLongLong()/restores).arg(restores);
+        diskLabel->setText(text);
+    }
+
+    struct EvictCandidate { QString name; qint64 kb; qint64 lastUse; };
+
+    // Clones only (not worktrees, snapshots or partial clones), least recently used
+    // first; a repository never used through here counts from its index mtime.
+    QList<EvictCandidate> evictionCandidates(const QMap<QString, qint64> &sizes) const
+    {
+        QSettings ws(workspaceFile(), QSettings::IniFormat);
+        QList<EvictCandidate> list;
+        for(auto it = sizes.begin(); it!=sizes.end(); ++it){
+            const QString path = QDir(localBaseDir).filePath(it.key());
+            if(it.key().startsWith('.') || !QFileInfo(path + "/.git").isDir() || ResumableClone::isPartial(path)) continue;
+            if(!QDir(path + "/.git/worktrees").isEmpty()) continue;     // linked worktrees point into .git
+            if(path==currentRepoPath() || watchers.contains(path) || (clones.contains(path) && !clones[path].done)) continue;
+            const qint64 used = ws.value("lastUse/" + it.key(), QFileInfo(path + "/.git/index").lastModified().toMSecsSinceEpoch()).toLongLong();
+            list << EvictCandidate{it.key(), it.value(), used};
+        }
+        std::sort(list.begin(), list.end(), [](const EvictCandidate &a, const EvictCandidate &b){ return a.lastUse<b.lastUse; });
+        return list;
+    }
+
+    void evictUntil(QList<EvictCandidate> todo, qint64 excessKb, qint64 totalKb)
+    {
+        if(excessKb<=0 || todo.isEmpty()){
+            if(excessKb>0) appendLog("Disk budget: still " + formatSize(excessKb*1024) + " over, nothing else can be evicted");
+            finishDiskBudget(totalKb);
+            return;
+        }
+        const EvictCandidate c = todo.takeFirst();
+        evictRepo(c.name, c.kb, [this, todo, excessKb, totalKb](qint64 freedKb){
+            evictUntil(todo, excessKb - freedKb, totalKb - freedKb);
+        });
+    }
+
+    // Only clean clones go; without a copy, only those whose commits (and stashes)
+    // are all on the remote.
+    void evictRepo(const QString &name, qint64 sizeKb, std::function<void(qint64)> done)
+    {
+        const QString path = QDir(localBaseDir).filePath(name);
+        const QString keep = evictKeepBox->currentText();
+        // ignored files (.env, local config, build output) are in neither a bundle nor .git
+        git(path, {"status", "--porcelain", "--ignored"}, 60000, [this, name, path, keep, sizeKb, done](const JobResult &st){
+            if(!st.ok || !st.out.trimmed().isEmpty()){
+                if(st.ok && st.out.startsWith("!! "))      // listed after changes and untracked files
+                    appendLog("Not evicting "+name+": it has ignored files");
+                done(0);
+                return;
+            }
+            if(keep=="nothing"){
+                git(path, {"rev-list", "-n", "1", "--branches", "--glob=refs/stash", "--not", "--remotes"}, 60000,
+                    [this, name, sizeKb, done](const JobResult &r){
+                    if(!r.ok || !r.out.trimmed().isEmpty()){ done(0); return; }
+                    discardRepo(name, "nothing", sizeKb, QString(), done);
+                })->readOnly = true;
+                return;
+            }
+            readCloneProfile(path, [this, name, path, keep, sizeKb, done](const CloneProfile &profile){
+                // a bundle needs every object: shallow and partial clones keep their .git
+                if(keep!="bundle" || !profile.usesObjectCache()){ discardRepo(name, "git dir", sizeKb, QString(), done); return; }
+                const QString bundle = QDir(evictedDir()).filePath(name + ".bundle");
+                QDir().mkpath(evictedDir());
+                git(path, {"rev-parse", "HEAD", "--symbolic-full-name", "HEAD"}, 10000, [this, name, path, bundle, sizeKb, done](const JobResult &head){
+                    if(!head.ok){ done(0); return; }
+                    // HEAD as a ref name, or the commit when detached
+                    const QStringList h = head.out.split('\n', QString::SkipEmptyParts);
+                    const QString at = h.value(1)=="HEAD" ? h.value(0) : h.value(1);
+                    git(path, {"bundle", "create", bundle, "--all"}, 0, [this, name, path, bundle, at, sizeKb, done](const JobResult &r){
+                        if(!r.ok){
+                            appendLog("Bundle of "+name+" failed, not evicted: "+r.err.trimmed());
+                            QFile::remove(bundle);
+                            done(0);
+                            return;
+                        }
+                        // remote, tracking and sparse-checkout settings are not in the bundle
+                        const QString base = QDir(evictedDir()).filePath(name);
+                        QFile::remove(base + ".config");
+                        QFile::remove(base + ".sparse");
+                        QFile::copy(path + "/.git/config", base + ".config");
+                        QFile::copy(path + "/.git/info/sparse-checkout", base + ".sparse");
+                        discardRepo(name, "bundle", sizeKb, at, done);
+                    })->readOnly = true;
+                })->readOnly = true;
+            });
+        })->readOnly = true;
+    }
+
+    // Moves the clone to the trash (keeping its .git for "git dir"), records the
+    // eviction and deletes the trash in the background.
+    void discardRepo(const QString &name, const QString &kind, qint64 sizeKb, const QString &head, std::function<void(qint64)> done)
+    {
+        const QString path = QDir(localBaseDir).filePath(name);
+        const QString trash = QDir(localBaseDir).filePath(QString(".git-manager/trash/%1-%2").arg(name).arg(QDateTime::currentMSecsSinceEpoch()));
+        const QString gitDir = QDir(evictedDir()).filePath(name + ".git");
+        QDir().mkpath(QFileInfo(trash).absolutePath());
+        QDir().mkpath(evictedDir());
+        if(kind=="git dir" && QFileInfo::exists(gitDir)){ done(0); return; }
+        if(!QDir().rename(path, trash)){ appendLog("Cannot move "+path+" to the trash, not evicted"); done(0); return; }
+        if(kind=="git dir" && !QDir().rename(trash + "/.git", gitDir)){
+            QDir().rename(trash, path);
+            appendLog("Cannot keep the .git of "+name+", not evicted");
+            done(0);
+            return;
+        }
+        statusCache->remove(path);
+        QSettings ws(workspaceFile(), QSettings::IniFormat);
+        ws.remove("lastUse/" + name);
+        if(kind!="nothing"){
+            ws.setValue("evicted/" + name + "/kind", kind);
+            ws.setValue("evicted/" + name + "/head", head);
+            ws.setValue("evicted/" + name + "/at", QDateTime::currentMSecsSinceEpoch());
+        }
+        jobs->submit("rm", {"-rf", "--", trash}, 0, [this, trash](const JobResult &r){
+            if(!r.ok) appendLog("Could not delete "+trash+": "+r.err.trimmed());
+        });
+        const QString kept = kind=="bundle" ? QDir(evictedDir()).filePath(name + ".bundle") : kind=="git dir" ? gitDir : QString();
+        if(kept.isEmpty()){
+            appendLog(QString("Evicted %1, freed %2").arg(name, formatSize(sizeKb*1024)));
+            done(sizeKb);
+            return;
+        }
+        jobs->submit("du", {"-sk", "--", kept}, 60000, [this, name, kind, sizeKb, done](const JobResult &r){
+            const qint64 keptKb = r.out.section('\t', 0, 0).toLongLong();
+            appendLog(QString("Evicted %1, freed %2, kept %3 (%4)").arg(name, formatSize((sizeKb-keptKb)*1024), formatSize(keptKb*1024), kind));
+            done(sizeKb - keptKb);
+        });
+    }
+
+    // Restore latency (from starting until the checkout is back) is logged and
+    // averaged in the disk label.
+    void restoreRepo(const QString &name)
+    {
+        if(restoring.contains(name)) return;
+        QSettings ws(workspaceFile(), QSettings::IniFormat);
+        const QString kind = ws.value("evicted/" + name + "/kind").toString();
+        const QString head = ws.value("evicted/" + name + "/head").toString();
+        const QString path = QDir(localBaseDir).filePath(name);
+        const QString base = QDir(evictedDir()).filePath(name);
+        if(QFileInfo::exists(path)){ appendLog("Cannot restore "+name+": "+path+" exists"); return; }
+        restoring.insert(name);
+        appendLog("Restoring "+name+" ("+kind+")");
+        QElapsedTimer timer;
+        timer.start();
+        auto finish = [this, name, kind, path, base, timer](const JobResult &r){
+            restoring.remove(name);
+            if(!r.ok){ appendLog("Restoring "+name+" failed: "+r.err.trimmed()); return; }
+            const qint64 ms = timer.elapsed();
+            QSettings ws(workspaceFile(), QSettings::IniFormat);
+            ws.remove("evicted/" + name);
+            ws.setValue("budget/restores", ws.value("budget/restores", 0).toInt() + 1);
+            ws.setValue("budget/restoreMs", ws.value("budget/restoreMs", 0).toLongLong() + ms);
+            for(const char *ext : {".bundle", ".config", ".sparse"}) QFile::remove(base + ext);
+            appendLog(QString("Restored %1 from %2 in %3 ms").arg(name, kind).arg(ms));
+            touchRepo(path);
+            helpers->invalidate(path);
+            if(currentRepoPath()==path) onRepoSelected();
+            checkDiskBudget();
+        };
+        const QStringList checkout{"-c", "checkout.workers=" + checkoutWorkers(), "reset", "--hard", "-q"};
+        if(kind=="git dir"){
+            QDir().mkpath(path);
+            if(!QDir().rename(base + ".git", path + "/.git")){
+                restoring.remove(name);
+                appendLog("Cannot move "+base+".git back to "+path);
+                return;
+            }
+            ws.remove("evicted/" + name);
+            gitStreamed(path, checkout, 0, finish);
+            return;
+        }
+        // A mirror clone of the bundle brings every ref back as it was; the saved
+        // config replaces the mirror's (and makes the repository non-bare again).
+        GitJob *job = jobs->submit("git", {"clone", "--mirror", "--progress", base + ".bundle", path + "/.git"}, 0,
+                                   [this, path, base, head, checkout, finish](const JobResult &r){
+            if(!r.ok){ finish(r); return; }
+            QFile::remove(path + "/.git/config");
+            QFile::copy(base + ".config", path + "/.git/config");
+            if(QFileInfo::exists(base + ".sparse")){
+                QDir().mkpath(path + "/.git/info");
+                QFile::copy(base + ".sparse", path + "/.git/info/sparse-checkout");
+            }
+            git(path, head.startsWith("refs/") ? QStringList{"symbolic-ref", "HEAD", head} : QStringList{"update-ref", "--no-deref", "HEAD", head}, 10000,
+                [this, path, checkout, finish](const JobResult &r){
+                if(r.ok) gitStreamed(path, checkout, 0, finish);
+                else finish(r);
+            });
+        }, path);
+        job->cleanupDir = path;
+    }
+
+    static QString formatDuration(qint64 ms)
+    {
+        qint64 s = ms/1000;
+        if(s>=3600) return QString("%1h%2m").arg(s/3600).arg((s%3600)/60, 2, 10, QChar('0'));
+        if(s>=60) return QString("%1m%2s").arg(s/60).arg(s%60, 2, 10, QChar('0'));
+        return QString("%1s").arg(s);
+    }
+
+    // A watcher for the selected repository and for every pinned one that is cloned.
+    void updateWatchers()
+    {
+        QSet<QString> wanted;
+        if(liveStatusBox->isChecked()){
+            if(!currentRepoPath().isEmpty()) wanted.insert(currentRepoPath());
+            for(const QString &name : pinnedRepos) wanted.insert(QDir(localBaseDir).filePath(name));
+        }
+        for(const QString &p : watchers.keys())
+            if(!wanted.contains(p) || !QDir(p).exists()) watchers.take(p)->deleteLater();
+        for(const QString &p : wanted){
+            if(watchers.contains(p) || !QFileInfo::exists(p + "/.git")) continue;
+            auto *w = new StatusWatcher(jobs, p, [this](const QString &repo, bool useCache, std::function<void(const StatusResult &, bool)> cb){
+                bool valid = false;
+                const StatusResult cached = statusCache->lookup(repo, &valid);
+                if(useCache && valid) cb(cached, true);
+                else computeStatus(repo, [cb](const StatusResult &st){ cb(st, false); });
+            }, this);
+            connect(w, &StatusWatcher::changed, this, [this, p](const StatusResult &st, bool incremental){
+                if(incremental) statusCache->store(p, st);
+                showStatus(p, st);
+            });
+            watchers[p] = w;
+        }
+    }
+
+    // Status from the backend, remembered in the cache.
+    void computeStatus(const QString &repo, std::function<void(const StatusResult &)> cb, JobPriority priority=JobPriority::Interactive)
+    {
+        const StatusCache::Snapshot before = statusCache->snapshot(repo);
+        backend()->status(repo, [this, repo, cb, before](const StatusResult &st){
+            statusCache->store(repo, st, &before);
+            cb(st);
+        }, priority);
+    }
+
+    void showStatus(const QString &path, const StatusResult &st)
+    {
+        if(currentRepoPath()!=path) return;     // selection moved on meanwhile
+        const QString selected = fileList->currentItem() ? fileList->currentItem()->data(PathRole).toString() : QString();
+        fileList->clear();
+        if(!st.ok){ appendLog("Status failed: "+st.error); return; }
+        if(!st.branch.oid.isEmpty() || !st.branch.head.isEmpty()) headLabel->setText(branchText(st.branch));
+        if(st.entries.isEmpty()) fileList->addItem("Working tree clean");
+        for(const StatusEntry &e : st.entries){
+            auto *item = new QListWidgetItem(e.text());
+            item->setData(PathRole, e.path);
+            if(!e.origPath.isEmpty()) item->setData(OrigPathRole, e.origPath);
+            fileList->addItem(item);
+            if(e.path==selected) fileList->setCurrentItem(item);
+        }
+    }
+
+    static QString branchText(const BranchStatus &b)
+    {
+        QString text = (b.head.isEmpty() ? QString("detached") : b.head) + " @ " + (b.oid.isEmpty() ? QString("(no commits)") : b.oid.left(7));
+        if(!b.upstream.isEmpty()) text += QString(", %1: ahead %2, behind %3").arg(b.upstream).arg(b.ahead).arg(b.behind);
+        return text;
+    }
+
+    void onRepoSelected()
+    {
+        headLabel->clear();
+        updateWatchers();
+        QString p = currentRepoPath();
+        if(!p.isEmpty() && QDir(p).exists()){
+            touchRepo(p);
+            // straight from the ref files: re-selecting a repository starts no process
+            const QString oid = readRef(p, "HEAD");
+            const QString branch = readHeadBranch(p);
+            const QString at = oid.isEmpty() || oid.startsWith("ref: ") ? QString("(no commits)") : oid.left(7);
+            headLabel->setText((branch.isEmpty() ? QString("detached") : branch) + " @ " + at);
+        }
+        // A watched repository answers from memory. Otherwise the cached status shows at
+        // once and, when it may be stale, is recomputed behind it.
+        StatusWatcher *w = watchers.value(p);
+        if(w && w->isWatching() && w->isCurrent()){ showStatus(p, w->status()); return; }
+        bool valid = false;
+        const StatusResult cached = QDir(p).exists() ? statusCache->lookup(p, &valid) : StatusResult();
+        if(cached.ok) showStatus(p, cached);
+        if(w && w->isPending()){ if(!cached.ok) fileList->clear(); return; }   // its first status is on the way
+        if(!cached.ok) onRefreshLocal();
+        else if(!valid) computeStatus(p, [this, p](const StatusResult &st){ showStatus(p, st); });
+    }
 
     void onRefreshLocal()
     {
         fileList->clear();
         QListWidgetItem *it = repoList->currentItem(); if(!it) return;
         QString name = it->text(); QString path = QDir(localBaseDir).filePath(name);
-        if(!QDir(path).exists()){ appendLog("Local missing: "+path); return; }
-
-        QString out, err;
-        runCommand("git", {"-C", path, "status", "--porcelain"}, out, err, 20000);
-        QStringList lines = out.split("",QString::SkipEmptyParts);
-        if(lines.isEmpty()) fileList->addItem("Working tree clean");
-        else for(auto &l: lines) fileList->addItem(l);
+        if(!QDir(path).exists()){
+            if(isEvicted(name)) restoreRepo(name);
+            else appendLog("Local missing: "+path);
+            return;
+        }
 
-        appendLog("Refreshed local state.");
+        if(StatusWatcher *w = watchers.value(path)){ w->refresh(); return; }
+        computeStatus(path, [this, path](const StatusResult &st){
+            showStatus(path, st);
+            if(st.ok && currentRepoPath()==path) appendLog("Refreshed local state.");
+        });
     }
 
     void onCheckUpdates()
     {
-        QListWidgetItem *it = repoList->currentItem(); if(!it){ QMessageBox::information(this,"Select","Select repo"); return; }
-        QString name = it->text(); QString p = QDir(localBaseDir).filePath(name);
-        appendLog("Fetching remote...");
+        QStringList repos = selectedLocalRepos();
+        if(repos.isEmpty()){ QMessageBox::information(this,"Select","Select repo"); return; }
+        appendLog(QString("Fetching remote for %1 repo(s)...").arg(repos.size()));
 
-        QString out, err;
-        runCommand("git", {"-C", p, "fetch"}, out, err, 60000);
-        appendLog(out+err);
+        // fetch and the HEAD lookup run concurrently; ahead/behind needs both.
+        PipelineStep profile = PipelineStep::custom("profile", [this](const PipelineContext &ctx, GitJob::Callback done){
+            readCloneProfile(ctx.repo, [done](const CloneProfile &p){
+                JobResult r;
+                r.ok = true;
+                r.out = p.fetchArgs().join(' ');
+                done(r);
+            });
+        });
+        PipelineStep fetch = PipelineStep::git("fetch", {}, {"profile"}).streamed();
+        fetch.attempts = RetryPolicy().attempts;
+        fetch.args = [](const PipelineContext &ctx){
+            return QStringList{"fetch"} + ctx.results["profile"].out.split(' ', QString::SkipEmptyParts);
+        };
+        fetch.timeoutMs = 60000;
+        PipelineStep head = PipelineStep::custom("head", [this](const PipelineContext &ctx, GitJob::Callback done){
+            backend()->head(ctx.repo, [done](const HeadInfo &h){
+                JobResult r;
+                r.ok = h.ok;
+                r.out = h.branch.isEmpty() ? QString("HEAD") : h.branch;
+                done(r);
+            });
+        });
+        PipelineStep count = PipelineStep::custom("count", [this](const PipelineContext &ctx, GitJob::Callback done){
+            helpers->invalidate(ctx.repo);
+            backend()->aheadBehind(ctx.repo, "origin/" + ctx.results["head"].out, [done](const AheadBehind &ab){
+                JobResult r;
+                r.ok = ab.ok;
+                r.out = QString("Behind: %1 Ahead: %2").arg(ab.behind).arg(ab.ahead);
+                r.err = ab.error;
+                done(r);
+            });
+        }, {"fetch", "head"});
 
-        QString brOut, brErr;
-        runCommand("git", {"-C", p, "rev-parse", "--abbrev-ref", "HEAD"}, brOut, brErr);
-        QString branch = brOut.trimmed();
-
-        QString cntOut, cntErr;
-        bool ok = runCommand("git", {"-C", p, "rev-list", "--left-right", "--count", QString("origin/%1...HEAD").arg(branch)}, cntOut, cntErr);
-        if(ok){
-            QStringList parts = cntOut.split(QRegExp("[	 ]"),QString::SkipEmptyParts);
-            if(parts.size()>=2)
-                QMessageBox::information(this,"Remote",QString("Behind: %1 Ahead: %2").arg(parts[0],parts[1]));
-        } else QMessageBox::information(this,"Remote",out+err);
+        Pipeline::runAll(jobs, repos, {profile, fetch, head, count}, this, [this](const PipelineResult &r){
+            QString name = QFileInfo(r.repo).fileName();
+            if(r.ok) appendLog(name + ": " + r.results["count"].out);
+            else if(r.cancelled) appendLog(name + ": fetch cancelled.");
+            else appendLog(name + ": update check failed in " + r.failed.join(", "));
+        }, [this](const QList<PipelineResult> &all){
+            if(all.size()==1){
+                const PipelineResult &r = all.first();
+                if(r.cancelled) return;
+                const JobResult &f = r.results["fetch"];
+                QMessageBox::information(this,"Remote", r.ok ? r.results["count"].out : f.out+f.err);
+                return;
+            }
+            QStringList lines;
+            for(const PipelineResult &r : all)
+                lines << QFileInfo(r.repo).fileName() + ": " + (r.ok ? r.results["count"].out : r.cancelled ? QString("cancelled") : QString("failed"));
+            QMessageBox::information(this,"Remote",lines.join('\n'));
+        });
     }
 
     void onPullSelected()
@@ -283,11 +4222,232 @@ private slots:
         QListWidgetItem *it = repoList->currentItem(); if(!it) return;
         QString name = it->text(); QString p = QDir(localBaseDir).filePath(name);
         appendLog("Pulling...");
-        QString out, err;
-        runCommand("git", {"-C", p, "pull"}, out, err, 120000);
-        appendLog(out+err);
-        QMessageBox::information(this,"Pull",out+err);
-        onRefreshLocal();
+        touchRepo(p);
+        readCloneProfile(p, [this, p](const CloneProfile &profile){
+            Retry::run(this, RetryPolicy(), [this, p, profile](int, GitJob::Callback done){
+                gitStreamed(p, QStringList{"pull"} + profile.fetchArgs(), 120000, done);
+            }, [this, p](const JobResult &r){
+                helpers->invalidate(p);
+                if(r.cancelled){ appendLog("Pull cancelled."); onRefreshLocal(); return; }
+                QMessageBox::information(this,"Pull",r.out+r.err);
+                onRefreshLocal();
+            }, [this](int retry, int delayMs, const JobResult &r){
+                appendLog(QString("Pull: %1 failure, retry %2 in %3s").arg(failureName(classifyFailure(r))).arg(retry).arg(delayMs/1000));
+            });
+        });
+    }
+
+    // Another branch of the selected repository in <repo>@<branch>: an existing local
+    // branch as is, a remote one as a new tracking branch, otherwise a new branch from HEAD.
+    void onAddWorktree()
+    {
+        QString repo = currentRepoPath();
+        if(repo.isEmpty() || !QDir(repo).exists()){ QMessageBox::information(this,"Select","Select a local repo"); return; }
+        bool ok = false;
+        QString branch = QInputDialog::getText(this, "Add Worktree", "Branch:", QLineEdit::Normal, QString(), &ok).trimmed();
+        if(!ok || branch.isEmpty()) return;
+        QString path = repo + "@" + QString(branch).replace('/', '-');
+        if(QDir(path).exists()){ appendLog("Already exists: "+path); return; }
+        git(repo, {"for-each-ref", "--format=%(refname)", "refs/heads/" + branch, "refs/remotes/origin/" + branch}, 10000,
+            [this, repo, branch, path](const JobResult &r){
+            QStringList refs = r.out.split('\n', QString::SkipEmptyParts);
+            QStringList args{"-c", "checkout.workers=" + checkoutWorkers(), "worktree", "add"};
+            if(refs.contains("refs/heads/" + branch)) args << path << branch;
+            else if(refs.contains("refs/remotes/origin/" + branch)) args << "--track" << "-b" << branch << path << "origin/" + branch;
+            else args << "-b" << branch << path;
+            appendLog("Adding worktree "+path);
+            GitJob *job = git(repo, args, 120000, [this, path](const JobResult &r){
+                if(r.ok) appendLog("Worktree ready: "+path);
+                else if(!r.cancelled) QMessageBox::warning(this, "Add Worktree", r.err);
+            });
+            job->cleanupDir = path;
+        })->readOnly = true;
+    }
+
+    void onSparseCheckout()
+    {
+        const QString repo = currentRepoPath();
+        if(repo.isEmpty() || !QDir(repo).exists()){ QMessageBox::information(this,"Select","Select a local repo"); return; }
+        GitJob *job = git(repo, {"ls-tree", "-d", "-r", "-z", "--name-only", "HEAD"}, 60000, [this, repo](const JobResult &dirs){
+            if(!dirs.ok){ if(!dirs.cancelled) QMessageBox::warning(this, "Sparse Checkout", dirs.err); return; }
+            QList<QByteArray> paths = dirs.output ? dirs.output->bytes().split('\0') : QList<QByteArray>();
+            GitJob *list = git(repo, {"sparse-checkout", "list"}, 10000, [this, repo, paths](const JobResult &cur){
+                // fails when the worktree is not sparse: everything is checked out
+                editSparseCheckout(repo, paths, cur.ok ? cur.out.split('\n', QString::SkipEmptyParts) : QStringList());
+            });
+            list->readOnly = true;
+            list->priority = JobPriority::Interactive;
+        });
+        job->readOnly = true;
+        job->priority = JobPriority::Interactive;
+    }
+
+    // Cone mode: a checked directory comes with everything below it; the files
+    // directly inside its parents are always included.
+    void editSparseCheckout(const QString &repo, const QList<QByteArray> &paths, const QStringList &selected)
+    {
+        QDialog dlg(this);
+        dlg.setWindowTitle("Sparse Checkout - " + QFileInfo(repo).fileName());
+        auto *l = new QVBoxLayout(&dlg);
+        l->addWidget(new QLabel("Directories to check out. Top-level files are always included;\nnothing checked means a full checkout."));
+        auto *tree = new QTreeWidget();
+        tree->setHeaderHidden(true);
+        QMap<QString, QTreeWidgetItem*> items;
+        for(const QByteArray &p : paths){      // parents come before their children
+            if(p.isEmpty()) continue;
+            const QString path = QString::fromUtf8(p);
+            auto *it = new QTreeWidgetItem(QStringList{path.section('/', -1)});
+            it->setData(0, Qt::UserRole, path);
+            it->setFlags(Qt::ItemIsEnabled | Qt::ItemIsUserCheckable | Qt::ItemIsAutoTristate);
+            it->setCheckState(0, Qt::Unchecked);
+            if(QTreeWidgetItem *parent = items.value(path.section('/', 0, -2))) parent->addChild(it);
+            else tree->addTopLevelItem(it);
+            items[path] = it;
+        }
+        for(const QString &s : selected) if(QTreeWidgetItem *it = items.value(s)) it->setCheckState(0, Qt::Checked);
+        auto *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+        connect(buttons, &QDialogButtonBox::accepted, &dlg, &QDialog::accept);
+        connect(buttons, &QDialogButtonBox::rejected, &dlg, &QDialog::reject);
+        l->addWidget(tree);
+        l->addWidget(buttons);
+        dlg.resize(500, 600);
+        if(dlg.exec()!=QDialog::Accepted) return;
+
+        QStringList dirs;
+        std::function<void(QTreeWidgetItem *)> collect = [&dirs, &collect](QTreeWidgetItem *it){
+            if(it->checkState(0)==Qt::Checked){ dirs << it->data(0, Qt::UserRole).toString(); return; }
+            if(it->checkState(0)==Qt::PartiallyChecked) for(int i=0; i<it->childCount(); ++i) collect(it->child(i));
+        };
+        for(int i=0; i<tree->topLevelItemCount(); ++i) collect(tree->topLevelItem(i));
+
+        QStringList args{"-c", "checkout.workers=" + checkoutWorkers(), "sparse-checkout"};
+        if(dirs.isEmpty()) args << "disable";
+        else args << "set" << "--cone" << dirs;
+        appendLog(dirs.isEmpty() ? "Full checkout of "+repo : QString("Sparse checkout of %1: %2 directories").arg(repo).arg(dirs.size()));
+        gitStreamed(repo, args, 0, [this, repo](const JobResult &r){
+            if(!r.ok && !r.cancelled) QMessageBox::warning(this, "Sparse Checkout", r.err);
+            if(currentRepoPath()==repo) onRefreshLocal();
+        });
+    }
+
+    //=========================== LARGE REPOSITORY MODE ======================
+    // Per repository: untracked cache, the built-in fsmonitor daemon, manyFiles
+    // (index v4) and, for cone-mode sparse checkouts, a sparse index. Marked with
+    // gitmanager.largeRepo; status is timed before and after switching it on.
+    void onLargeRepoMode()
+    {
+        const QString repo = currentRepoPath();
+        if(repo.isEmpty() || !QDir(repo).exists()){ QMessageBox::information(this,"Select","Select a local repo"); return; }
+        GitJob *job = git(repo, {"config", "--get", "gitmanager.largeRepo"}, 10000, [this, repo](const JobResult &r){
+            const QString name = QFileInfo(repo).fileName();
+            if(r.out.trimmed()=="true"){
+                if(QMessageBox::question(this, "Large Repo Mode", "Large-repo mode is on for "+name+". Turn it off?")==QMessageBox::Yes)
+                    disableLargeRepoMode(repo);
+                return;
+            }
+            if(QMessageBox::question(this, "Large Repo Mode", "Turn on large-repo mode for "+name+"?\n\n"
+                                     "Untracked cache, fsmonitor daemon, index v4 (feature.manyFiles) and, for a\n"
+                                     "cone-mode sparse checkout, a sparse index. Status is timed before and after.")==QMessageBox::Yes)
+                enableLargeRepoMode(repo);
+        });
+        job->readOnly = true;
+        job->priority = JobPriority::Interactive;
+    }
+
+    // Runs the commands one after another; stops at the first failure.
+    void gitSequence(const QString &repo, QList<QStringList> cmds, GitJob::Callback done)
+    {
+        if(cmds.isEmpty()){ JobResult r; r.ok = true; done(r); return; }
+        const QStringList cmd = cmds.takeFirst();
+        git(repo, cmd, 120000, [this, repo, cmds, done](const JobResult &r){
+            if(r.ok) gitSequence(repo, cmds, done);
+            else done(r);
+        });
+    }
+
+    // Best wall time of `runs` status calls, made the way the CLI backend makes them; -1 on failure.
+    void timeStatus(const QString &repo, int runs, std::function<void(qint64)> done)
+    {
+        GitJob *job = git(repo, {"--no-optional-locks", "status", "--porcelain=v2", "-z", "--branch"}, 0,
+                          [this, repo, runs, done](const JobResult &r){
+            if(!r.ok || r.usage.wallMs<0){ done(-1); return; }
+            const qint64 ms = r.usage.wallMs;
+            if(runs<=1){ done(ms); return; }
+            timeStatus(repo, runs-1, [ms, done](qint64 rest){ done(rest<0 ? ms : qMin(ms, rest)); });
+        });
+        job->readOnly = true;
+    }
+
+    void enableLargeRepoMode(const QString &repo)
+    {
+        appendLog("Large-repo mode for "+repo+": timing status...");
+        timeStatus(repo, 2, [this, repo](qint64 before){
+            gitSequence(repo, {{"config", "core.untrackedCache", "true"},
+                               {"config", "feature.manyFiles", "true"},
+                               {"config", "index.version", "4"},
+                               {"config", "core.fsmonitor", "true"},
+                               {"config", "gitmanager.largeRepo", "true"}}, [this, repo, before](const JobResult &r){
+                if(!r.ok){ QMessageBox::warning(this, "Large Repo Mode", r.err); return; }
+                auto notes = std::make_shared<QStringList>();
+                git(repo, {"fsmonitor--daemon", "start"}, 30000, [this, repo, before, notes](const JobResult &fsm){
+                    // the built-in daemon needs git 2.36+ and a supported platform
+                    if(!fsm.ok && !fsm.err.contains("already running")){
+                        *notes << "fsmonitor: " + fsm.err.trimmed().section('\n', 0, 0);
+                        git(repo, {"config", "--unset", "core.fsmonitor"}, 10000, nullptr);
+                    }
+                    GitJob *cone = git(repo, {"config", "--get", "core.sparseCheckoutCone"}, 10000, [this, repo, before, notes](const JobResult &c){
+                        auto finish = [this, repo, before, notes](){
+                            // rewrite the index now; the non-optional-locks status stores the untracked cache and fsmonitor token
+                            gitSequence(repo, {{"update-index", "--index-version", "4", "--untracked-cache"},
+                                               {"status", "--porcelain=v2", "-z"}}, [this, repo, before, notes](const JobResult &r){
+                                if(!r.ok) *notes << "index: " + r.err.trimmed().section('\n', 0, 0);
+                                timeStatus(repo, 2, [this, repo, before, notes](qint64 after){ reportLargeRepoMode(repo, before, after, *notes); });
+                            });
+                        };
+                        if(c.out.trimmed()!="true"){ *notes << "sparse index: not a cone-mode sparse checkout"; finish(); return; }
+                        gitSequence(repo, {{"config", "index.sparse", "true"}, {"sparse-checkout", "reapply"}}, [this, repo, notes, finish](const JobResult &r){
+                            if(!r.ok){
+                                *notes << "sparse index: " + r.err.trimmed().section('\n', 0, 0);
+                                git(repo, {"config", "--unset", "index.sparse"}, 10000, nullptr);
+                            }
+                            finish();
+                        });
+                    });
+                    cone->readOnly = true;
+                });
+            });
+        });
+    }
+
+    // Reads the settings back rather than trusting what was written.
+    void reportLargeRepoMode(const QString &repo, qint64 before, qint64 after, const QStringList &notes)
+    {
+        auto ms = [](qint64 v){ return v<0 ? QString("failed") : QString("%1 ms").arg(v); };
+        GitJob *cfg = git(repo, {"config", "--get-regexp", "^(core\\.untrackedcache|core\\.fsmonitor|feature\\.manyfiles|index\\.version|index\\.sparse)$"}, 10000,
+                          [this, repo, before, after, notes, ms](const JobResult &c){
+            GitJob *daemon = git(repo, {"fsmonitor--daemon", "status"}, 10000, [this, repo, before, after, notes, ms, c](const JobResult &d){
+                QStringList lines{QString("status: %1 before, %2 after").arg(ms(before), ms(after))};
+                lines << c.out.trimmed().split('\n', QString::SkipEmptyParts);
+                if(c.out.contains("core.fsmonitor")) lines << "fsmonitor daemon: " + (d.ok ? d.out : d.err).trimmed();
+                lines << notes;
+                appendLog("Large-repo mode for "+repo+": " + lines.join("; "));
+                QMessageBox::information(this, "Large Repo Mode - " + QFileInfo(repo).fileName(), lines.join('\n'));
+            });
+            daemon->readOnly = true;
+        });
+        cfg->readOnly = true;
+    }
+
+    void disableLargeRepoMode(const QString &repo)
+    {
+        git(repo, {"fsmonitor--daemon", "stop"}, 30000, [this, repo](const JobResult &){
+            // one by one: --unset fails for a key that was never set
+            for(const char *key : {"core.untrackedCache", "core.fsmonitor", "feature.manyFiles", "index.version", "index.sparse", "gitmanager.largeRepo"})
+                git(repo, {"config", "--unset", key}, 10000, nullptr);
+            git(repo, {"update-index", "--no-untracked-cache"}, 60000, [this, repo](const JobResult &r){
+                appendLog("Large-repo mode off for "+repo + (r.ok ? QString() : ": " + r.err.trimmed()));
+            });
+        });
     }
 
     void onShowDiff()
@@ -296,35 +4456,67 @@ private slots:
         QListWidgetItem *file = fileList->currentItem();
         if(!repo || !file){ QMessageBox::information(this,"Select","Select file"); return; }
         QString name = repo->text(); QString p = QDir(localBaseDir).filePath(name);
-        QString entry = file->text();
+        const QString path = file->data(PathRole).toString();
+        if(path.isEmpty()) return;      // "Working tree clean"
 
-        QString path;
-        if(entry.contains("	")) path = entry.section("	",1);
-        else if(entry.size()>3) path = entry.mid(3).trimmed();
-        if(path.isEmpty()) path=entry;
-
-        QString out, err;
-        runCommand("git", {"-C", p, "diff", "--", path}, out, err, 20000);
-        diffView->setPlainText(out+err);
+        backend()->diffFile(p, path, [this, p](QSharedPointer<OutputBuffer> out){
+            if(currentRepoPath()!=p) return;
+            diffOutput = out;
+            diffPageStarts = {0};
+            showDiffPage();
+        });
     }
 
     void onPushIfChanged()
     {
-        QListWidgetItem *it = repoList->currentItem(); if(!it) return;
-        QString name = it->text(); QString p = QDir(localBaseDir).filePath(name);
-        QString out, err;
-        runCommand("git", {"-C", p, "status", "--porcelain"}, out, err);
-        if(out.trimmed().isEmpty()){ QMessageBox::information(this,"Clean","Nothing to push"); return; }
+        QStringList repos = selectedLocalRepos();
+        if(repos.isEmpty()) return;
+        auto dirty = std::make_shared<QStringList>();
+        auto left = std::make_shared<int>(repos.size());
+        for(const QString &p : repos){
+            computeStatus(p, [this, p, dirty, left](const StatusResult &st){     // never trust the cache for a push
+                if(!st.ok) appendLog(QFileInfo(p).fileName() + ": status failed: " + st.error);
+                else if(!st.entries.isEmpty()) *dirty << p;
+                if(--*left==0) commitAndPush(*dirty);
+            });
+        }
+    }
+
+    // add -> commit -> push on every repository concurrently; a failing step stops its repo's chain.
+    void commitAndPush(const QStringList &repos)
+    {
+        if(repos.isEmpty()){ QMessageBox::information(this,"Clean","Nothing to push"); return; }
 
         bool ok;
         QString msg = QInputDialog::getText(this,"Commit message","Message:",QLineEdit::Normal,"Update",&ok);
         if(!ok) return;
 
-        runCommand("git", {"-C", p, "add", "-A"}, out, err);
-        runCommand("git", {"-C", p, "commit", "-m", msg}, out, err);
-        runCommand("git", {"-C", p, "push"}, out, err);
-        QMessageBox::information(this,"Pushed",out+err);
-        onRefreshLocal();
+        QList<PipelineStep> steps = {
+            PipelineStep::git("add", {"add", "-A"}),
+            PipelineStep::git("commit", {"commit", "-m", msg}, {"add"}).streamed(),
+            PipelineStep::git("push", {"push"}, {"commit"}).streamed(),
+        };
+        Pipeline::runAll(jobs, repos, steps, this, [this](const PipelineResult &r){
+            helpers->invalidate(r.repo);
+            touchRepo(r.repo);
+            QString name = QFileInfo(r.repo).fileName();
+            if(r.ok) appendLog(name + ": pushed.");
+            else if(r.cancelled) appendLog(name + ": push cancelled.");
+            else appendLog(name + ": stopped at " + r.failed.join(", ") + (r.skipped.isEmpty() ? QString() : ", skipped " + r.skipped.join(", ")));
+        }, [this](const QList<PipelineResult> &all){
+            if(all.size()==1){
+                const PipelineResult &r = all.first();
+                if(!r.cancelled){
+                    const JobResult &last = r.results.value(r.failed.value(0, "push"));
+                    QMessageBox::information(this, r.ok ? "Pushed" : "Push failed", last.out+last.err);
+                }
+            } else {
+                int pushed = 0;
+                for(const PipelineResult &r : all) if(r.ok) ++pushed;
+                QMessageBox::information(this,"Pushed",QString("Pushed %1 of %2 repositories (details in log).").arg(pushed).arg(all.size()));
+            }
+            onRefreshLocal();
+        });
     }
 };
 